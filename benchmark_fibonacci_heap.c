@@ -0,0 +1,1403 @@
+#define _GNU_SOURCE
+#include "fibonacci_heap.h"
+#include "fib_heap_shm.h"
+#include "fib_heap_bounded.h"
+#include "fib_heap_event_loop.h"
+#include "fib_heap_sched.h"
+#include "fib_heap_trace.h"
+#include "fib_heap_arena.h"
+#include "fib_heap_extmem.h"
+#include "fib_heap_bucket.h"
+#include "fib_heap_mpsc.h"
+#include <pthread.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// Benchmark registry entry
+typedef struct {
+    const char* name;
+    const char* description;
+    void (*run)(void);
+} benchmark_t;
+
+// Wall-clock time in seconds
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Size parameter, overridable through the environment
+static long bench_param(const char* name, long default_value) {
+    const char* value = getenv(name);
+    return value ? atol(value) : default_value;
+}
+
+// Fast deterministic generator for long streams
+static uint64_t bench_xorshift(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+// Benchmark: core insert / decrease-key / extract-min mix
+static void bench_core(void) {
+    const int n = 1000000;
+    fib_heap_t* heap = fib_heap_create();
+    fib_node_t** nodes = malloc(n * sizeof(fib_node_t*));
+
+    srand(42);
+    double start = now_seconds();
+    for (int i = 0; i < n; i++) {
+        nodes[i] = fib_heap_insert(heap, rand(), NULL);
+    }
+    double t_insert = now_seconds();
+
+    for (int i = 0; i < n / 10; i++) {
+        fib_node_t* node = nodes[rand() % n];
+        fib_heap_decrease_key(heap, node, fib_node_get_key(node) / 2);
+    }
+    double t_decrease = now_seconds();
+
+    while (!fib_heap_empty(heap)) {
+        free(fib_heap_extract_min(heap));
+    }
+    double t_extract = now_seconds();
+
+    printf("  insert:       %8.1f ns/op\n", (t_insert - start) * 1e9 / n);
+    printf("  decrease_key: %8.1f ns/op\n", (t_decrease - t_insert) * 1e9 / (n / 10));
+    printf("  extract_min:  %8.1f ns/op\n", (t_extract - t_decrease) * 1e9 / n);
+
+    free(nodes);
+    fib_heap_destroy(heap);
+}
+
+// Benchmark: extract-min on a heap whose nodes are scattered in memory
+static void bench_consolidate(void) {
+    const long n = bench_param("FIB_BENCH_NODES", 2000000L);
+    fib_heap_t* heap = fib_heap_create();
+    void** spacers = malloc(n * sizeof(void*));
+    uint64_t rng = 12345;
+
+    // Interleave node allocations with odd-sized spacers so neighbouring
+    // root-list entries land on different cache lines and pages
+    for (long i = 0; i < n; i++) {
+        fib_heap_insert(heap, (int)(bench_xorshift(&rng) >> 33), NULL);
+        spacers[i] = malloc(64 + bench_xorshift(&rng) % 512);
+    }
+    for (long i = 0; i < n; i++) {
+        free(spacers[i]);
+    }
+
+    // First extract consolidates all n singleton roots
+    double start = now_seconds();
+    free(fib_heap_extract_min(heap));
+    double t_first = now_seconds();
+    while (!fib_heap_empty(heap)) {
+        free(fib_heap_extract_min(heap));
+    }
+    double t_rest = now_seconds();
+
+    printf("  nodes=%ld (override with FIB_BENCH_NODES)\n", n);
+    printf("  first consolidate: %8.3f ms\n", (t_first - start) * 1e3);
+    printf("  extract_min:       %8.1f ns/op\n", (t_rest - t_first) * 1e9 / (n - 1));
+    printf("  run 'make perf-stat' for cache-miss counters\n");
+
+    free(spacers);
+    fib_heap_destroy(heap);
+}
+
+// Build a heap whose nodes went through heavy allocator churn
+static fib_heap_t* bench_build_fragmented(long n, uint64_t seed) {
+    fib_heap_t* heap = fib_heap_create();
+    fib_node_t** nodes = malloc(n * sizeof(fib_node_t*));
+    void** spacers = malloc(n * sizeof(void*));
+    uint64_t rng = seed;
+
+    for (long i = 0; i < n; i++) {
+        nodes[i] = fib_heap_insert(heap, (int)(bench_xorshift(&rng) >> 33), NULL);
+        spacers[i] = malloc(32 + bench_xorshift(&rng) % 256);
+    }
+    free(fib_heap_extract_min(heap));
+
+    // Delete and re-insert a third of the nodes into the scattered free space
+    for (long i = 0; i < n; i += 3) {
+        free(spacers[i]);
+        spacers[i] = NULL;
+    }
+    for (long i = 1; i < n; i += 3) {
+        if (nodes[i] && nodes[i] != fib_heap_minimum(heap)) {
+            fib_heap_delete_node(heap, nodes[i]);
+            fib_heap_insert(heap, (int)(bench_xorshift(&rng) >> 33), NULL);
+        }
+    }
+    free(fib_heap_extract_min(heap));
+
+    for (long i = 0; i < n; i++) {
+        free(spacers[i]);
+    }
+    free(spacers);
+    free(nodes);
+    return heap;
+}
+
+// Time draining a heap completely
+static double bench_drain_seconds(fib_heap_t* heap) {
+    double start = now_seconds();
+    while (!fib_heap_empty(heap)) {
+        fib_heap_free_node(heap, fib_heap_extract_min(heap));
+    }
+    return now_seconds() - start;
+}
+
+// Benchmark: traversal cost before and after compaction
+static void bench_compact(void) {
+    const long n = bench_param("FIB_BENCH_NODES", 1000000L);
+
+    fib_heap_t* fragmented = bench_build_fragmented(n, 99);
+    fib_heap_t* compacted = bench_build_fragmented(n, 99);
+
+    double start = now_seconds();
+    bool done = false;
+    long calls = 0;
+    while (!done) {
+        fib_heap_compact(compacted, 65536, NULL, NULL, &done);
+        calls++;
+    }
+    double t_compact = now_seconds() - start;
+
+    double t_fragmented = bench_drain_seconds(fragmented);
+    double t_compacted = bench_drain_seconds(compacted);
+
+    printf("  nodes=%ld (override with FIB_BENCH_NODES)\n", n);
+    printf("  compaction:           %8.1f ms in %ld budgeted calls\n", t_compact * 1e3, calls);
+    printf("  drain, fragmented:    %8.1f ms\n", t_fragmented * 1e3);
+    printf("  drain, compacted:     %8.1f ms\n", t_compacted * 1e3);
+
+    fib_heap_destroy(fragmented);
+    fib_heap_destroy(compacted);
+}
+
+// Random directed graph in compressed sparse row form
+typedef struct {
+    int vertex_count;
+    int* offsets;               // Edges of v are [offsets[v], offsets[v + 1])
+    int* targets;
+    int* weights;
+} bench_graph_t;
+
+static bench_graph_t bench_graph_create(int vertex_count, int degree, uint64_t seed) {
+    bench_graph_t graph;
+    uint64_t rng = seed;
+    long edge_count = (long)vertex_count * degree;
+
+    graph.vertex_count = vertex_count;
+    graph.offsets = malloc((vertex_count + 1) * sizeof(int));
+    graph.targets = malloc(edge_count * sizeof(int));
+    graph.weights = malloc(edge_count * sizeof(int));
+
+    for (int v = 0; v <= vertex_count; v++) {
+        graph.offsets[v] = v * degree;
+    }
+    for (long e = 0; e < edge_count; e++) {
+        graph.targets[e] = (int)(bench_xorshift(&rng) % vertex_count);
+        graph.weights[e] = 1 + (int)(bench_xorshift(&rng) % 100);
+    }
+    return graph;
+}
+
+static void bench_graph_destroy(bench_graph_t* graph) {
+    free(graph->offsets);
+    free(graph->targets);
+    free(graph->weights);
+}
+
+// Dijkstra from vertex 0; returns the sum of finite distances as a checksum
+static long bench_dijkstra_fib(const bench_graph_t* graph, bool batched, bool monotone) {
+    int n = graph->vertex_count;
+    fib_heap_t* heap = fib_heap_create();
+    if (monotone) {
+        fib_heap_set_monotone(heap, true);
+    }
+    fib_node_t** handles = malloc(n * sizeof(fib_node_t*));
+    int* dist = malloc(n * sizeof(int));
+    int* ids = malloc(n * sizeof(int));
+    fib_node_t** batch_nodes = malloc(n * sizeof(fib_node_t*));
+    int* batch_keys = malloc(n * sizeof(int));
+
+    for (int v = 0; v < n; v++) {
+        ids[v] = v;
+        dist[v] = (v == 0) ? 0 : INT_MAX;
+        handles[v] = fib_heap_insert(heap, dist[v], &ids[v]);
+    }
+
+    long checksum = 0;
+    while (!fib_heap_empty(heap)) {
+        fib_node_t* min = fib_heap_extract_min(heap);
+        int u = *(int*)min->data;
+        fib_heap_free_node(heap, min);
+        handles[u] = NULL;
+        if (dist[u] == INT_MAX) {
+            break;
+        }
+        checksum += dist[u];
+
+        size_t pending = 0;
+        for (int e = graph->offsets[u]; e < graph->offsets[u + 1]; e++) {
+            int v = graph->targets[e];
+            int candidate = dist[u] + graph->weights[e];
+            if (handles[v] && candidate < dist[v]) {
+                dist[v] = candidate;
+                if (batched) {
+                    batch_nodes[pending] = handles[v];
+                    batch_keys[pending] = candidate;
+                    pending++;
+                } else {
+                    fib_heap_decrease_key(heap, handles[v], candidate);
+                }
+            }
+        }
+        if (pending) {
+            fib_heap_decrease_key_batch(heap, batch_nodes, batch_keys, pending);
+        }
+    }
+
+    free(batch_nodes);
+    free(batch_keys);
+    free(ids);
+    free(dist);
+    free(handles);
+    fib_heap_destroy(heap);
+    return checksum;
+}
+
+// Benchmark: Dijkstra with per-edge versus batched decrease-key, and radix buckets
+static void bench_dijkstra(void) {
+    static const struct {
+        const char* label;
+        bool batched;
+        bool monotone;
+    } variants[] = {
+        {"fib heap, per-edge:", false, false},
+        {"fib heap, batched:", true, false},
+        {"radix heap:", false, true},
+    };
+
+    const int vertices = (int)bench_param("FIB_BENCH_VERTICES", 200000L);
+    const int degree = (int)bench_param("FIB_BENCH_DEGREE", 32L);
+    bench_graph_t graph = bench_graph_create(vertices, degree, 2024);
+
+    printf("  vertices=%d degree=%d (override with FIB_BENCH_VERTICES / FIB_BENCH_DEGREE)\n",
+           vertices, degree);
+
+    for (size_t i = 0; i < sizeof(variants) / sizeof(variants[0]); i++) {
+        double start = now_seconds();
+        long checksum = bench_dijkstra_fib(&graph, variants[i].batched, variants[i].monotone);
+        double elapsed = now_seconds() - start;
+        printf("  %-22s %8.1f ms (checksum %ld)\n", variants[i].label, elapsed * 1e3, checksum);
+    }
+
+    bench_graph_destroy(&graph);
+}
+
+// Idle timeout callback: rearm as a new idle timeout, like a keep-alive
+static void bench_idle_timeout_cb(fib_event_loop_t* loop, void* user_ctx) {
+    fib_event_loop_add_timer(loop, 30000 + (uint32_t)((uintptr_t)user_ctx % 30000),
+                             bench_idle_timeout_cb, user_ctx);
+}
+
+// CPU time used by this process in seconds
+static double bench_cpu_seconds(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+// Benchmark: many concurrent idle timeouts in the event loop
+static void bench_timers(void) {
+    const long timers = bench_param("FIB_BENCH_TIMERS", 1000000L);
+    const long seconds = bench_param("FIB_BENCH_SECONDS", 3L);
+    fib_event_loop_t* loop = fib_event_loop_create();
+    uint64_t rng = 77;
+
+    // Deadlines spread over 1..61 s; a few percent expire during the run
+    double start = now_seconds();
+    for (long i = 0; i < timers; i++) {
+        uint32_t timeout = 1000 + (uint32_t)(bench_xorshift(&rng) % 60000);
+        fib_event_loop_add_timer(loop, timeout, bench_idle_timeout_cb, (void*)(uintptr_t)i);
+    }
+    double t_schedule = now_seconds() - start;
+
+    fib_event_loop_stats_t before = fib_event_loop_get_stats(loop);
+    double wall_start = now_seconds();
+    double cpu_start = bench_cpu_seconds();
+    while (now_seconds() - wall_start < seconds) {
+        fib_event_loop_run_once(loop, 100);
+    }
+    double wall = now_seconds() - wall_start;
+    double cpu = bench_cpu_seconds() - cpu_start;
+    fib_event_loop_stats_t after = fib_event_loop_get_stats(loop);
+
+    printf("  timers=%ld run=%lds (override with FIB_BENCH_TIMERS / FIB_BENCH_SECONDS)\n",
+           timers, seconds);
+    printf("  schedule:        %8.1f ns/timer\n", t_schedule * 1e9 / timers);
+    printf("  wakeups/s:       %8.1f\n", (after.wakeups - before.wakeups) / wall);
+    printf("  timers fired/s:  %8.1f\n", (after.timers_fired - before.timers_fired) / wall);
+    printf("  timerfd arms/s:  %8.1f\n", (after.timerfd_arms - before.timerfd_arms) / wall);
+    printf("  CPU:             %8.2f%% of one core\n", 100.0 * cpu / wall);
+
+    fib_event_loop_destroy(loop);
+}
+
+// Benchmark: stable (key, seq) ordering versus plain key ordering
+static void bench_stable(void) {
+    const int n = 1000000;
+    const int distinct_keys = 16;
+    fib_node_t** nodes = malloc(n * sizeof(fib_node_t*));
+
+    for (int mode = 0; mode < 2; mode++) {
+        fib_heap_t* heap = fib_heap_create();
+        fib_heap_set_stable(heap, mode == 1);
+
+        srand(7);
+        double start = now_seconds();
+        for (int i = 0; i < n; i++) {
+            nodes[i] = fib_heap_insert(heap, distinct_keys + rand() % distinct_keys, NULL);
+        }
+        for (int i = 0; i < n / 10; i++) {
+            fib_heap_decrease_key(heap, nodes[rand() % n], rand() % distinct_keys);
+        }
+        while (!fib_heap_empty(heap)) {
+            free(fib_heap_extract_min(heap));
+        }
+        double elapsed = now_seconds() - start;
+
+        printf("  %-10s %8.1f ns per inserted element\n",
+               mode ? "stable:" : "unstable:", elapsed * 1e9 / n);
+        fib_heap_destroy(heap);
+    }
+
+    free(nodes);
+}
+
+// Benchmark: streaming top-K with a capacity-bounded heap
+static void bench_topk(void) {
+    const long stream = bench_param("FIB_BENCH_STREAM", 10000000L);
+    const long k = bench_param("FIB_BENCH_TOPK", 10000L);
+    fib_bounded_heap_t* heap = fib_bounded_heap_create((size_t)k);
+    uint64_t rng = 0x9e3779b97f4a7c15ULL;
+    long accepted = 0;
+
+    double start = now_seconds();
+    for (long i = 0; i < stream; i++) {
+        bool kept;
+        fib_bounded_heap_insert(heap, (int)(bench_xorshift(&rng) >> 33), NULL, &kept, NULL);
+        accepted += kept;
+    }
+    double elapsed = now_seconds() - start;
+
+    printf("  stream=%ld K=%ld (override with FIB_BENCH_STREAM / FIB_BENCH_TOPK)\n", stream, k);
+    printf("  accepted:  %ld (%.4f%%)\n", accepted, 100.0 * accepted / stream);
+    printf("  time:      %.3f s, %.1f ns/item, %.1f M items/s\n",
+           elapsed, elapsed * 1e9 / stream, stream / elapsed / 1e6);
+
+    fib_bounded_heap_destroy(heap);
+}
+
+// Benchmark: shared-memory heap hammered by several processes
+static void bench_shm(void) {
+    const int ops_per_process = 200000;
+    const int process_counts[] = {1, 2, 4, 8};
+    const char* shm_name = "/fibheap-bench";
+
+    for (size_t p = 0; p < sizeof(process_counts) / sizeof(process_counts[0]); p++) {
+        int processes = process_counts[p];
+        size_t region_size = fib_shm_heap_region_size((size_t)processes * ops_per_process);
+
+        int fd = shm_open(shm_name, O_CREAT | O_RDWR | O_TRUNC, 0600);
+        if (fd < 0 || ftruncate(fd, region_size) != 0) {
+            perror("shm_open");
+            return;
+        }
+        void* region = mmap(NULL, region_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (region == MAP_FAILED) {
+            perror("mmap");
+            shm_unlink(shm_name);
+            return;
+        }
+        fib_shm_heap_t* heap = fib_shm_heap_init(region, region_size);
+
+        // Pre-populate so extracts operate on a realistically sized heap
+        for (int i = 0; i < ops_per_process; i++) {
+            fib_shm_heap_insert(heap, rand(), 0, NULL);
+        }
+
+        double start = now_seconds();
+        for (int w = 0; w < processes; w++) {
+            if (fork() == 0) {
+                // Each worker maps the object itself, as an unrelated process would
+                int child_fd = shm_open(shm_name, O_RDWR, 0600);
+                void* child_region = mmap(NULL, region_size, PROT_READ | PROT_WRITE,
+                                          MAP_SHARED, child_fd, 0);
+                close(child_fd);
+                fib_shm_heap_t* child_heap = fib_shm_heap_attach(child_region);
+                unsigned int seed = (unsigned int)w + 1;
+                for (int i = 0; i < ops_per_process; i++) {
+                    if (i & 1) {
+                        fib_shm_heap_extract_min(child_heap, NULL, NULL);
+                    } else {
+                        fib_shm_heap_insert(child_heap, rand_r(&seed), (uint64_t)w, NULL);
+                    }
+                }
+                _exit(0);
+            }
+        }
+        for (int w = 0; w < processes; w++) {
+            wait(NULL);
+        }
+        double elapsed = now_seconds() - start;
+
+        double total_ops = (double)processes * ops_per_process;
+        printf("  %d process(es): %10.0f ops/s (%6.1f ns/op)\n",
+               processes, total_ops / elapsed, elapsed * 1e9 / total_ops);
+
+        munmap(region, region_size);
+        shm_unlink(shm_name);
+    }
+}
+
+// Scheduler workload: a fan-out task graph where each task burns a fixed
+// amount of CPU and spawns two children with random priorities
+static long sched_task_work = 1000;
+
+static void bench_spin(long iterations) {
+    volatile long sink = 0;
+    for (long i = 0; i < iterations; i++) {
+        sink += i;
+    }
+}
+
+static void bench_sched_task(fib_sched_t* sched, size_t worker, void* user_ctx) {
+    uintptr_t depth = (uintptr_t)user_ctx;
+    bench_spin(sched_task_work);
+    if (depth > 0) {
+        uint64_t state = (uint64_t)(uintptr_t)&depth ^ depth;
+        for (int c = 0; c < 2; c++) {
+            int priority = (int)(bench_xorshift(&state) % 1000000);
+            fib_sched_submit(sched, worker, priority, bench_sched_task, (void*)(depth - 1));
+        }
+    }
+}
+
+// Baseline: every thread shares one heap behind one mutex
+typedef struct {
+    pthread_mutex_t lock;
+    fib_heap_t* heap;
+    long outstanding;           // Queued plus running tasks
+} bench_shared_queue_t;
+
+static void* bench_shared_worker(void* arg) {
+    bench_shared_queue_t* queue = (bench_shared_queue_t*)arg;
+    uint64_t state = (uint64_t)(uintptr_t)&queue ^ 0x9e3779b97f4a7c15ULL;
+
+    for (;;) {
+        pthread_mutex_lock(&queue->lock);
+        fib_node_t* node = fib_heap_extract_min(queue->heap);
+        long outstanding = queue->outstanding;
+        pthread_mutex_unlock(&queue->lock);
+
+        if (!node) {
+            if (outstanding == 0) {
+                return NULL;
+            }
+            sched_yield();
+            continue;
+        }
+
+        uintptr_t depth = (uintptr_t)node->data;
+        fib_heap_free_node(queue->heap, node);
+        bench_spin(sched_task_work);
+
+        pthread_mutex_lock(&queue->lock);
+        if (depth > 0) {
+            for (int c = 0; c < 2; c++) {
+                fib_heap_insert(queue->heap, (int)(bench_xorshift(&state) % 1000000),
+                                (void*)(depth - 1));
+            }
+            queue->outstanding += 2;
+        }
+        queue->outstanding--;
+        pthread_mutex_unlock(&queue->lock);
+    }
+}
+
+static double bench_shared_queue_run(int threads, int roots, int depth) {
+    bench_shared_queue_t queue;
+    pthread_mutex_init(&queue.lock, NULL);
+    queue.heap = fib_heap_create();
+    queue.outstanding = roots;
+    for (int i = 0; i < roots; i++) {
+        fib_heap_insert(queue.heap, rand() % 1000000, (void*)(uintptr_t)depth);
+    }
+
+    pthread_t* ids = (pthread_t*)malloc(threads * sizeof(pthread_t));
+    double start = now_seconds();
+    for (int t = 0; t < threads; t++) {
+        pthread_create(&ids[t], NULL, bench_shared_worker, &queue);
+    }
+    for (int t = 0; t < threads; t++) {
+        pthread_join(ids[t], NULL);
+    }
+    double elapsed = now_seconds() - start;
+
+    free(ids);
+    fib_heap_destroy(queue.heap);
+    pthread_mutex_destroy(&queue.lock);
+    return elapsed;
+}
+
+// Benchmark: work-stealing scheduler vs one shared heap, 1..64 threads
+static void bench_sched(void) {
+    const long max_threads = bench_param("FIB_BENCH_MAX_THREADS", 64L);
+    const int depth = (int)bench_param("FIB_BENCH_DEPTH", 11L);
+    const int roots = 64;
+    const int bound = (int)bench_param("FIB_BENCH_INVERSION_BOUND", 100000L);
+    sched_task_work = bench_param("FIB_BENCH_TASK_WORK", 1000L);
+    const double tasks = (double)roots * ((2L << depth) - 1);
+
+    printf("  %.0f tasks, %ld spin iterations each, inversion bound %d, %ld online CPU(s)\n",
+           tasks, sched_task_work, bound, sysconf(_SC_NPROCESSORS_ONLN));
+    printf("  %7s %16s %16s %10s %12s\n", "threads", "stealing tasks/s", "shared tasks/s",
+           "steals", "bound steals");
+
+    for (long threads = 1; threads <= max_threads; threads *= 2) {
+        fib_sched_t* sched = fib_sched_create((size_t)threads, bound);
+        double start = now_seconds();
+        for (int i = 0; i < roots; i++) {
+            fib_sched_submit(sched, FIB_SCHED_ANY_WORKER, rand() % 1000000, bench_sched_task,
+                             (void*)(uintptr_t)depth);
+        }
+        fib_sched_wait_idle(sched);
+        double t_stealing = now_seconds() - start;
+        fib_sched_stats_t stats = fib_sched_get_stats(sched);
+        fib_sched_destroy(sched);
+
+        double t_shared = bench_shared_queue_run((int)threads, roots, depth);
+
+        printf("  %7ld %16.0f %16.0f %10zu %12zu\n", threads, tasks / t_stealing,
+               tasks / t_shared, stats.steals, stats.inversion_steals);
+    }
+}
+
+// Peek benchmark: one writer churning under a mutex, readers peeking
+typedef struct {
+    fib_heap_t* heap;
+    pthread_mutex_t lock;
+    bool lock_free;             // Readers use fib_heap_peek_min instead of the mutex
+    int stop;
+    long writer_ops;
+} bench_peek_shared_t;
+
+typedef struct {
+    bench_peek_shared_t* shared;
+    long reads;
+    long checksum;
+} bench_peek_reader_t;
+
+static void* bench_peek_writer(void* arg) {
+    bench_peek_shared_t* shared = (bench_peek_shared_t*)arg;
+    uint64_t state = 99;
+    long ops = 0;
+    while (!__atomic_load_n(&shared->stop, __ATOMIC_RELAXED)) {
+        pthread_mutex_lock(&shared->lock);
+        fib_heap_insert(shared->heap, (int)(bench_xorshift(&state) % 1000000), NULL);
+        fib_heap_free_node(shared->heap, fib_heap_extract_min(shared->heap));
+        pthread_mutex_unlock(&shared->lock);
+        ops += 2;
+    }
+    shared->writer_ops = ops;
+    return NULL;
+}
+
+static void* bench_peek_reader(void* arg) {
+    bench_peek_reader_t* reader = (bench_peek_reader_t*)arg;
+    bench_peek_shared_t* shared = reader->shared;
+    long reads = 0;
+    long checksum = 0;
+    while (!__atomic_load_n(&shared->stop, __ATOMIC_RELAXED)) {
+        if (shared->lock_free) {
+            checksum += fib_heap_peek_min(shared->heap).key + (long)fib_heap_size(shared->heap);
+        } else {
+            pthread_mutex_lock(&shared->lock);
+            checksum += fib_heap_minimum(shared->heap)->key + (long)fib_heap_size(shared->heap);
+            pthread_mutex_unlock(&shared->lock);
+        }
+        reads++;
+    }
+    reader->reads = reads;
+    reader->checksum = checksum;
+    return NULL;
+}
+
+// Benchmark: peek throughput under a steady write load, mutex vs published minimum
+static void bench_peek(void) {
+    const long max_readers = bench_param("FIB_BENCH_MAX_READERS", 8L);
+    const double duration = bench_param("FIB_BENCH_MILLIS", 500L) / 1000.0;
+
+    printf("  %7s %10s %16s %16s\n", "readers", "mode", "reads/s", "writer ops/s");
+    for (long readers = 1; readers <= max_readers; readers *= 2) {
+        for (int mode = 0; mode < 2; mode++) {
+            bench_peek_shared_t shared;
+            shared.heap = fib_heap_create();
+            pthread_mutex_init(&shared.lock, NULL);
+            shared.lock_free = mode == 1;
+            shared.stop = 0;
+            shared.writer_ops = 0;
+            fib_heap_set_concurrent(shared.heap, shared.lock_free);
+            for (int i = 0; i < 100000; i++) {
+                fib_heap_insert(shared.heap, rand() % 1000000, NULL);
+            }
+
+            bench_peek_reader_t* state = (bench_peek_reader_t*)calloc(readers, sizeof(bench_peek_reader_t));
+            pthread_t* ids = (pthread_t*)malloc((readers + 1) * sizeof(pthread_t));
+            pthread_create(&ids[readers], NULL, bench_peek_writer, &shared);
+            for (long r = 0; r < readers; r++) {
+                state[r].shared = &shared;
+                pthread_create(&ids[r], NULL, bench_peek_reader, &state[r]);
+            }
+
+            struct timespec pause = {(time_t)duration, (long)((duration - (time_t)duration) * 1e9)};
+            nanosleep(&pause, NULL);
+            __atomic_store_n(&shared.stop, 1, __ATOMIC_RELAXED);
+
+            long reads = 0;
+            for (long r = 0; r <= readers; r++) {
+                pthread_join(ids[r], NULL);
+            }
+            for (long r = 0; r < readers; r++) {
+                reads += state[r].reads;
+            }
+
+            printf("  %7ld %10s %16.0f %16.0f\n", readers, shared.lock_free ? "peek" : "mutex",
+                   reads / duration, shared.writer_ops / duration);
+
+            free(ids);
+            free(state);
+            fib_heap_destroy(shared.heap);
+            pthread_mutex_destroy(&shared.lock);
+        }
+    }
+}
+
+// Mixed workload for the trace benchmark: live nodes are kept in an array
+// (node data holds the index) so random decrease-key and delete targets can
+// be drawn and extracted nodes removed in O(1)
+static void bench_mix_forget(fib_node_t** live, size_t* live_count, fib_node_t* node) {
+    size_t index = (size_t)(uintptr_t)node->data;
+    live[index] = live[--*live_count];
+    live[index]->data = (void*)(uintptr_t)index;
+}
+
+static double bench_mix_run(fib_trace_t* trace, long ops) {
+    const size_t steady = 100000;
+    fib_heap_t* heap = fib_heap_create();
+    fib_heap_t* side = fib_heap_create();
+    fib_node_t** live = (fib_node_t**)malloc((steady + (size_t)ops) * sizeof(fib_node_t*));
+    size_t live_count = 0;
+    uint64_t rng = 2024;
+
+    if (trace) {
+        fib_trace_attach(trace, heap);
+        fib_trace_attach(trace, side);
+    }
+
+    for (size_t i = 0; i < steady; i++) {
+        live[live_count] = fib_heap_insert(heap, (int)(bench_xorshift(&rng) % 1000000),
+                                           (void*)(uintptr_t)live_count);
+        live_count++;
+    }
+
+    double start = now_seconds();
+    for (long i = 0; i < ops; i++) {
+        unsigned int dice = (unsigned int)(bench_xorshift(&rng) % 100);
+        if (dice < 40 || live_count == 0) {
+            live[live_count] = fib_heap_insert(heap, (int)(bench_xorshift(&rng) % 1000000),
+                                               (void*)(uintptr_t)live_count);
+            live_count++;
+        } else if (dice < 75) {
+            fib_node_t* node = fib_heap_extract_min(heap);
+            bench_mix_forget(live, &live_count, node);
+            fib_heap_free_node(heap, node);
+        } else if (dice < 95) {
+            fib_node_t* node = live[bench_xorshift(&rng) % live_count];
+            fib_heap_decrease_key(heap, node, node->key - (int)(bench_xorshift(&rng) % 1000));
+        } else if (dice < 99) {
+            fib_node_t* node = live[bench_xorshift(&rng) % live_count];
+            bench_mix_forget(live, &live_count, node);
+            fib_heap_delete_node(heap, node);
+        } else {
+            // Merge a small batch built on the side heap
+            for (int j = 0; j < 8; j++) {
+                live[live_count] = fib_heap_insert(side, (int)(bench_xorshift(&rng) % 1000000),
+                                                   (void*)(uintptr_t)live_count);
+                live_count++;
+            }
+            fib_heap_union(heap, side);
+        }
+    }
+    double elapsed = now_seconds() - start;
+
+    fib_heap_destroy(side);
+    fib_heap_destroy(heap);
+    free(live);
+    return elapsed;
+}
+
+// Benchmark: recording overhead; also leaves a trace for fibheap-replay
+static void bench_trace(void) {
+    const long ops = bench_param("FIB_BENCH_OPS", 2000000L);
+    const char* path = getenv("FIB_BENCH_TRACE");
+    if (!path) {
+        path = "fibheap.trace";
+    }
+
+    double t_plain = bench_mix_run(NULL, ops);
+
+    fib_trace_t* trace = fib_trace_create(1 << 16, path);
+    if (!trace) {
+        perror(path);
+        return;
+    }
+    double t_traced = bench_mix_run(trace, ops);
+    uint64_t records = fib_trace_total_records(trace);
+    fib_trace_destroy(trace);
+
+    printf("  mixed ops (40%% insert, 35%% extract, 20%% decrease, 4%% delete, 1%% union): %ld\n", ops);
+    printf("  untraced:      %8.1f ns/op\n", t_plain * 1e9 / ops);
+    printf("  traced (file): %8.1f ns/op (%+.1f%%)\n", t_traced * 1e9 / ops,
+           100.0 * (t_traced - t_plain) / t_plain);
+    printf("  trace:         %s, %llu records, %.1f MB\n", path, (unsigned long long)records,
+           records * sizeof(fib_trace_record_t) / 1e6);
+    printf("  replay with:   ./fibheap-replay %s\n", path);
+}
+
+// Insert, decrease-key and drain a heap built with the given allocator
+static double bench_placement_run(const fib_heap_allocator_t* allocator, int n) {
+    fib_heap_t* heap = fib_heap_create_with_allocator(allocator);
+    fib_node_t** nodes = malloc(n * sizeof(fib_node_t*));
+    uint64_t rng = 99;
+
+    double start = now_seconds();
+    for (int i = 0; i < n; i++) {
+        nodes[i] = fib_heap_insert(heap, (int)(bench_xorshift(&rng) % 1000000000), NULL);
+    }
+    // Random decrease-keys and a drain touch the nodes in no useful order
+    for (int i = 0; i < n / 2; i++) {
+        fib_node_t* node = nodes[bench_xorshift(&rng) % n];
+        fib_heap_decrease_key(heap, node, node->key / 2);
+    }
+    while (!fib_heap_empty(heap)) {
+        fib_heap_free_node(heap, fib_heap_extract_min(heap));
+    }
+    double elapsed = now_seconds() - start;
+
+    fib_heap_destroy(heap);
+    free(nodes);
+    return elapsed;
+}
+
+// Benchmark: node placement with malloc, an arena, and arenas bound to the
+// local and a remote NUMA node
+static void bench_numa(void) {
+    const int n = (int)bench_param("FIB_BENCH_NODES", 1000000L);
+
+    // Stay on one CPU so "local" keeps meaning the same node
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(sched_getcpu(), &cpus);
+    sched_setaffinity(0, sizeof(cpus), &cpus);
+
+    int nodes = fib_numa_node_count();
+    int local = fib_numa_current_node();
+    int remote = (local + 1) % nodes;
+    printf("  nodes=%d, pinned to cpu %d on node %d (override size with FIB_BENCH_NODES)\n",
+           nodes, sched_getcpu(), local);
+    if (nodes == 1) {
+        printf("  single-node machine: the remote arena is the local node again\n");
+    }
+
+    printf("  %-22s %8.1f ms\n", "malloc:", bench_placement_run(NULL, n) * 1e3);
+
+    const struct {
+        const char* label;
+        int node;
+    } variants[] = {
+        {"arena, any node:", FIB_ARENA_ANY_NODE},
+        {"arena, local node:", local},
+        {"arena, remote node:", remote},
+    };
+    for (size_t i = 0; i < sizeof(variants) / sizeof(variants[0]); i++) {
+        fib_arena_t* arena = fib_arena_create(0, variants[i].node);
+        fib_heap_allocator_t allocator = fib_arena_allocator(arena);
+        double elapsed = bench_placement_run(&allocator, n);
+        fib_arena_stats_t stats = fib_arena_get_stats(arena);
+        printf("  %-22s %8.1f ms (%.1f MB mapped%s)\n", variants[i].label, elapsed * 1e3,
+               stats.bytes_mapped / 1e6, stats.unbound_mappings ? ", mbind unavailable" : "");
+        fib_arena_destroy(arena);
+    }
+}
+
+// dTLB load-miss counter for this thread, or -1 when perf events are unavailable
+static int bench_dtlb_counter_open(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+// Build a large heap, then time (and count dTLB misses of) extract-min with
+// consolidation and decrease-keys over the whole node set
+static void bench_hugepage_run(const char* label, fib_arena_t* arena, int n) {
+    fib_heap_allocator_t allocator;
+    if (arena) {
+        allocator = fib_arena_allocator(arena);
+    }
+    fib_heap_t* heap = fib_heap_create_with_allocator(arena ? &allocator : NULL);
+    fib_node_t** nodes = malloc(n * sizeof(fib_node_t*));
+    uint64_t rng = 7;
+
+    for (int i = 0; i < n; i++) {
+        nodes[i] = fib_heap_insert(heap, (int)(bench_xorshift(&rng) % 1000000000), &nodes[i]);
+    }
+
+    int counter = bench_dtlb_counter_open();
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    // The first extract links all n roots; the rest chase pointers across the forest
+    double start = now_seconds();
+    for (int i = 0; i < n / 10; i++) {
+        fib_node_t* min = fib_heap_extract_min(heap);
+        *(fib_node_t**)min->data = NULL;
+        fib_heap_free_node(heap, min);
+        fib_node_t* node = nodes[bench_xorshift(&rng) % n];
+        if (node && node->key > 0 && node->parent) {
+            fib_heap_decrease_key(heap, node, node->key / 2);
+        }
+    }
+    double elapsed = now_seconds() - start;
+
+    uint64_t misses = 0;
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(counter, &misses, sizeof(misses)) != sizeof(misses)) {
+            misses = 0;
+        }
+        close(counter);
+    }
+
+    size_t bytes = 0, huge_bytes = 0;
+    if (arena) {
+        fib_arena_page_usage(arena, &bytes, &huge_bytes);
+    }
+    printf("  %-16s %8.1f ms", label, elapsed * 1e3);
+    if (counter >= 0) {
+        printf("  dTLB load misses %12llu", (unsigned long long)misses);
+    } else {
+        printf("  dTLB load misses          n/a");
+    }
+    if (bytes) {
+        printf("  huge pages %5.1f%% of %.0f MB", 100.0 * huge_bytes / bytes, bytes / 1e6);
+    }
+    printf("\n");
+
+    free(nodes);
+    fib_heap_destroy(heap);
+}
+
+// Benchmark: extract-min over a large heap on base pages versus huge pages
+static void bench_hugepage(void) {
+    const int n = (int)bench_param("FIB_BENCH_NODES", 4000000L);
+    printf("  nodes=%d, extract-min + decrease-key over n/10 rounds (override with FIB_BENCH_NODES)\n", n);
+
+    bench_hugepage_run("malloc:", NULL, n);
+
+    const struct {
+        const char* label;
+        fib_arena_pages_t pages;
+    } variants[] = {
+        {"arena, base:", FIB_ARENA_PAGES_BASE},
+        {"arena, THP:", FIB_ARENA_PAGES_THP},
+        {"arena, hugetlb:", FIB_ARENA_PAGES_HUGETLB},
+    };
+    for (size_t i = 0; i < sizeof(variants) / sizeof(variants[0]); i++) {
+        fib_arena_t* arena = fib_arena_create(0, FIB_ARENA_ANY_NODE);
+        fib_arena_set_pages(arena, variants[i].pages);
+        bench_hugepage_run(variants[i].label, arena, n);
+        fib_arena_stats_t stats = fib_arena_get_stats(arena);
+        if (stats.hugetlb_fallbacks) {
+            printf("  %-16s %zu of %zu chunks fell back to THP (hugetlbfs pool empty)\n", "",
+                   stats.hugetlb_fallbacks, stats.chunks);
+        }
+        fib_arena_destroy(arena);
+    }
+}
+
+// Build a heap in its typical steady state: inserted, partly consolidated
+static fib_heap_t* bench_drain_heap(int n) {
+    fib_heap_t* heap = fib_heap_create();
+    uint64_t rng = 5;
+    for (int i = 0; i < n; i++) {
+        fib_heap_insert(heap, (int)(bench_xorshift(&rng) % 1000000000), NULL);
+    }
+    fib_heap_free_node(heap, fib_heap_extract_min(heap));
+    for (int i = 0; i < n / 10; i++) {
+        fib_heap_insert(heap, (int)(bench_xorshift(&rng) % 1000000000), NULL);
+    }
+    return heap;
+}
+
+static void bench_drain_sink(int key, void* data, void* user_ctx) {
+    (void)data;
+    *(long*)user_ctx += key;
+}
+
+// Benchmark: shutdown drain, extract-min loop versus sorted drain
+static void bench_drain(void) {
+    const int n = (int)bench_param("FIB_BENCH_NODES", 1000000L);
+    printf("  nodes=%d (override with FIB_BENCH_NODES)\n", n);
+
+    fib_heap_t* heap = bench_drain_heap(n);
+    size_t size = fib_heap_size(heap);
+    int* keys = malloc(size * sizeof(int));
+    void** data = malloc(size * sizeof(void*));
+
+    double start = now_seconds();
+    size_t i = 0;
+    while (!fib_heap_empty(heap)) {
+        fib_node_t* min = fib_heap_extract_min(heap);
+        keys[i] = min->key;
+        data[i++] = min->data;
+        free(min);
+    }
+    double t_loop = now_seconds() - start;
+    long loop_checksum = 0;
+    for (i = 0; i < size; i++) {
+        loop_checksum += keys[i];
+    }
+    fib_heap_destroy(heap);
+
+    heap = bench_drain_heap(n);
+    start = now_seconds();
+    fib_heap_drain_sorted(heap, keys, data);
+    double t_drain = now_seconds() - start;
+    fib_heap_destroy(heap);
+
+    heap = bench_drain_heap(n);
+    long callback_checksum = 0;
+    start = now_seconds();
+    fib_heap_drain_sorted_fn(heap, bench_drain_sink, &callback_checksum);
+    double t_callback = now_seconds() - start;
+    fib_heap_destroy(heap);
+
+    printf("  %-26s %8.1f ms\n", "extract-min + free loop:", t_loop * 1e3);
+    printf("  %-26s %8.1f ms (%.1fx)\n", "drain_sorted, arrays:", t_drain * 1e3, t_loop / t_drain);
+    printf("  %-26s %8.1f ms (%.1fx)%s\n", "drain_sorted, callback:", t_callback * 1e3,
+           t_loop / t_callback, callback_checksum == loop_checksum ? "" : "  CHECKSUM MISMATCH");
+
+    free(keys);
+    free(data);
+}
+
+// Helper: consolidated heap of n random keys, handles in nodes[]
+static fib_heap_t* bench_cancel_heap(int n, fib_node_t** nodes) {
+    fib_heap_t* heap = fib_heap_create();
+    uint64_t rng = 9;
+    for (int i = 0; i < n; i++) {
+        nodes[i] = fib_heap_insert(heap, (int)(bench_xorshift(&rng) % 1000000000), NULL);
+    }
+    fib_node_t* min = fib_heap_extract_min(heap);
+    for (int i = 0; i < n; i++) {
+        if (nodes[i] == min) {
+            nodes[i] = NULL;
+        }
+    }
+    free(min);
+    return heap;
+}
+
+// Helper: sum of the next `count` minimums, to check both variants agree
+static long bench_cancel_checksum(fib_heap_t* heap, int count) {
+    long sum = 0;
+    for (int i = 0; i < count && !fib_heap_empty(heap); i++) {
+        fib_node_t* min = fib_heap_extract_min(heap);
+        sum += min->key;
+        free(min);
+    }
+    return sum;
+}
+
+// Benchmark: a burst of cancellations, delete_node versus cancel + purge
+static void bench_cancel(void) {
+    const int n = (int)bench_param("FIB_BENCH_NODES", 1000000L);
+    const int burst = (int)bench_param("FIB_BENCH_BURST", 100000L);
+    printf("  nodes=%d burst=%d (override with FIB_BENCH_NODES, FIB_BENCH_BURST)\n", n, burst);
+
+    fib_node_t** nodes = malloc((size_t)n * sizeof(fib_node_t*));
+    int* victims = malloc((size_t)burst * sizeof(int));
+    uint64_t rng = 17;
+    for (int i = 0; i < burst; i++) {
+        victims[i] = (int)(bench_xorshift(&rng) % (uint64_t)n);
+    }
+
+    fib_heap_t* heap = bench_cancel_heap(n, nodes);
+    double start = now_seconds();
+    for (int i = 0; i < burst; i++) {
+        fib_node_t* node = nodes[victims[i]];
+        if (node) {
+            fib_heap_delete_node(heap, node);
+            nodes[victims[i]] = NULL;
+        }
+    }
+    double t_delete = now_seconds() - start;
+    size_t delete_size = fib_heap_size(heap);
+    long delete_checksum = bench_cancel_checksum(heap, 1000);
+    fib_heap_destroy(heap);
+
+    heap = bench_cancel_heap(n, nodes);
+    start = now_seconds();
+    for (int i = 0; i < burst; i++) {
+        fib_node_t* node = nodes[victims[i]];
+        if (node) {
+            fib_heap_cancel(heap, node);
+            nodes[victims[i]] = NULL;
+        }
+    }
+    double t_mark = now_seconds() - start;
+    fib_heap_purge(heap);
+    double t_cancel = now_seconds() - start;
+    size_t cancel_size = fib_heap_size(heap);
+    long cancel_checksum = bench_cancel_checksum(heap, 1000);
+    fib_heap_destroy(heap);
+
+    bool match = delete_size == cancel_size && delete_checksum == cancel_checksum;
+    printf("  %-26s %8.1f ms\n", "delete_node per node:", t_delete * 1e3);
+    printf("  %-26s %8.1f ms\n", "cancel (marking only):", t_mark * 1e3);
+    printf("  %-26s %8.1f ms (%.1fx)%s\n", "cancel + purge:", t_cancel * 1e3, t_delete / t_cancel,
+           match ? "" : "  CHECKSUM MISMATCH");
+
+    free(victims);
+    free(nodes);
+}
+
+// Benchmark: external-memory queue, fill + decrease-key + drain, I/O volume per mode
+static void bench_extmem(void) {
+    const long n = bench_param("FIB_BENCH_NODES", 4000000L);
+    const long head = bench_param("FIB_BENCH_HEAD", 262144L);
+    printf("  items=%ld head=%ld, 10%% decrease-keyed (override with FIB_BENCH_NODES, FIB_BENCH_HEAD)\n",
+           n, head);
+
+    const struct {
+        const char* name;
+        fib_extmem_io_t io;
+    } modes[] = {{"buffered", FIB_EXTMEM_IO_BUFFERED}, {"mmap", FIB_EXTMEM_IO_MMAP}};
+    const double item_bytes = 24.0;     // On-disk record size
+    long checksums[2] = {0, 0};
+
+    for (int m = 0; m < 2; m++) {
+        fib_extmem_config_t config = {(size_t)head, 0, 0, NULL, modes[m].io};
+        fib_extmem_t* queue = fib_extmem_create(&config);
+        if (!queue) {
+            printf("  %s: cannot create queue\n", modes[m].name);
+            continue;
+        }
+
+        uint64_t rng = 21;
+        double start = now_seconds();
+        for (long i = 0; i < n; i++) {
+            fib_extmem_push(queue, (int)(bench_xorshift(&rng) % 1000000000), (uint64_t)i);
+        }
+        for (long i = 0; i < n / 10; i++) {
+            uint64_t id = bench_xorshift(&rng) % (uint64_t)n;
+            fib_extmem_decrease_key(queue, id, -(int)(bench_xorshift(&rng) % 1000000));
+        }
+        double t_fill = now_seconds() - start;
+        fib_extmem_stats_t filled = fib_extmem_get_stats(queue);
+
+        start = now_seconds();
+        int key;
+        uint64_t id;
+        long popped = 0;
+        while (fib_extmem_pop(queue, &key, &id) == FIB_HEAP_SUCCESS) {
+            checksums[m] += key ^ (long)id;
+            popped++;
+        }
+        double t_drain = now_seconds() - start;
+        fib_extmem_stats_t stats = fib_extmem_get_stats(queue);
+        fib_extmem_destroy(queue);
+
+        printf("  %-9s fill %7.1f ms  drain %7.1f ms  (%ld items)\n", modes[m].name,
+               t_fill * 1e3, t_drain * 1e3, popped);
+        printf("            written %7.1f MiB (%.2fx the data), read %7.1f MiB, "
+               "%llu runs, %llu merges, %llu stale copies dropped\n",
+               stats.bytes_written / 1048576.0, stats.bytes_written / (item_bytes * n),
+               stats.bytes_read / 1048576.0, (unsigned long long)stats.runs_written,
+               (unsigned long long)stats.merges, (unsigned long long)stats.stale_dropped);
+        printf("            after fill: %zu runs open, %.1f MiB written\n", filled.runs,
+               filled.bytes_written / 1048576.0);
+    }
+    if (checksums[0] != checksums[1]) {
+        printf("  CHECKSUM MISMATCH between modes\n");
+    }
+}
+
+// Benchmark: few distinct keys, one node per item versus one node per key
+static void bench_bucket(void) {
+    const long n = bench_param("FIB_BENCH_NODES", 2000000L);
+    const long distinct = bench_param("FIB_BENCH_KEYS", 256L);
+    printf("  items=%ld distinct keys=%ld (override with FIB_BENCH_NODES, FIB_BENCH_KEYS)\n", n, distinct);
+
+    int* keys = malloc((size_t)n * sizeof(int));
+    uint64_t rng = 29;
+    for (long i = 0; i < n; i++) {
+        keys[i] = (int)(bench_xorshift(&rng) % (uint64_t)distinct);
+    }
+
+    // Fill, then drain half while refilling, then drain the rest
+    long checksums[3] = {0, 0, 0};
+    const char* labels[] = {"fib_heap:", "fib_heap (stable):"};
+    for (int mode = 0; mode < 2; mode++) {
+        fib_heap_t* heap = fib_heap_create();
+        fib_heap_set_stable(heap, mode == 1);
+        double start = now_seconds();
+        for (long i = 0; i < n; i++) {
+            fib_heap_insert(heap, keys[i], NULL);
+        }
+        for (long i = 0; i < n; i++) {
+            fib_node_t* node = fib_heap_extract_min(heap);
+            checksums[mode] += node->key * (i & 7);
+            fib_heap_free_node(heap, node);
+            if (i < n / 2) {
+                fib_heap_insert(heap, keys[i] + (int)distinct / 2, NULL);
+            }
+        }
+        while (!fib_heap_empty(heap)) {
+            fib_heap_free_node(heap, fib_heap_extract_min(heap));
+        }
+        printf("  %-26s %8.1f ms\n", labels[mode], (now_seconds() - start) * 1e3);
+        fib_heap_destroy(heap);
+    }
+
+    fib_bucket_heap_t* bucket_heap = fib_bucket_heap_create();
+    double start = now_seconds();
+    for (long i = 0; i < n; i++) {
+        fib_bucket_heap_insert(bucket_heap, keys[i], NULL);
+    }
+    for (long i = 0; i < n; i++) {
+        checksums[2] += fib_bucket_heap_extract_min(bucket_heap).key * (i & 7);
+        if (i < n / 2) {
+            fib_bucket_heap_insert(bucket_heap, keys[i] + (int)distinct / 2, NULL);
+        }
+    }
+    while (fib_bucket_heap_extract_min(bucket_heap).valid) {
+    }
+    double t_bucket = now_seconds() - start;
+    fib_bucket_heap_destroy(bucket_heap);
+
+    printf("  %-26s %8.1f ms%s\n", "bucket heap:", t_bucket * 1e3,
+           checksums[0] == checksums[2] && checksums[1] == checksums[2] ? "" : "  CHECKSUM MISMATCH");
+    free(keys);
+}
+
+// MPSC benchmark: producers insert under a mutex or through the ring while
+// the calling thread extracts
+typedef struct {
+    fib_heap_t* heap;
+    pthread_mutex_t* lock;      // Locked fib_heap_insert when set
+    fib_mpsc_t* queue;          // fib_mpsc_insert otherwise
+    long count;
+    int seed;
+    double busy;                // Seconds spent inside insert calls
+    double* samples;            // Latency of every 16th call, in ns
+    long sample_count;
+} bench_mpsc_producer_t;
+
+static void* bench_mpsc_producer(void* arg) {
+    bench_mpsc_producer_t* producer = (bench_mpsc_producer_t*)arg;
+    uint64_t state = (uint64_t)producer->seed * 0x9e3779b97f4a7c15ULL + 1;
+    for (long i = 0; i < producer->count; i++) {
+        int key = (int)(bench_xorshift(&state) % 1000000);
+        double start = now_seconds();
+        if (producer->lock) {
+            pthread_mutex_lock(producer->lock);
+            fib_heap_insert(producer->heap, key, NULL);
+            pthread_mutex_unlock(producer->lock);
+        } else {
+            while (fib_mpsc_insert(producer->queue, key, NULL, NULL) != FIB_HEAP_SUCCESS) {
+                sched_yield();      // Ring full: the consumer is behind
+            }
+        }
+        double elapsed = now_seconds() - start;
+        producer->busy += elapsed;
+        if ((i & 15) == 0) {
+            producer->samples[producer->sample_count++] = elapsed * 1e9;
+        }
+    }
+    return NULL;
+}
+
+static int bench_compare_double(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Benchmark: producer insert latency and consumer throughput, mutex versus MPSC ring
+static void bench_mpsc(void) {
+    const long producers = bench_param("FIB_BENCH_PRODUCERS", 4L);
+    const long per_producer = bench_param("FIB_BENCH_NODES", 500000L);
+    const long total = producers * per_producer;
+    printf("  producers=%ld items=%ld each (override with FIB_BENCH_PRODUCERS, FIB_BENCH_NODES)\n",
+           producers, per_producer);
+    printf("  %-6s %14s %14s %16s %10s\n", "mode", "insert mean", "insert p99", "consumer items/s",
+           "batches");
+
+    for (int mode = 0; mode < 2; mode++) {
+        fib_heap_t* heap = fib_heap_create();
+        pthread_mutex_t lock;
+        pthread_mutex_init(&lock, NULL);
+        fib_mpsc_t* queue = mode == 1 ? fib_mpsc_create(heap, 0) : NULL;
+
+        bench_mpsc_producer_t* state = calloc((size_t)producers, sizeof(bench_mpsc_producer_t));
+        pthread_t* ids = malloc((size_t)producers * sizeof(pthread_t));
+        double start = now_seconds();
+        for (long p = 0; p < producers; p++) {
+            state[p].heap = heap;
+            state[p].lock = mode == 0 ? &lock : NULL;
+            state[p].queue = queue;
+            state[p].count = per_producer;
+            state[p].seed = (int)p + 1;
+            state[p].samples = malloc((size_t)(per_producer / 16 + 1) * sizeof(double));
+            pthread_create(&ids[p], NULL, bench_mpsc_producer, &state[p]);
+        }
+
+        // The consumer extracts as fast as items arrive
+        long received = 0;
+        while (received < total) {
+            fib_node_t* node;
+            if (queue) {
+                node = fib_mpsc_extract_min(queue);
+            } else {
+                pthread_mutex_lock(&lock);
+                node = fib_heap_extract_min(heap);
+                pthread_mutex_unlock(&lock);
+            }
+            if (node) {
+                fib_heap_free_node(heap, node);
+                received++;
+            } else {
+                sched_yield();
+            }
+        }
+        double elapsed = now_seconds() - start;
+
+        double busy = 0;
+        long sample_count = 0;
+        for (long p = 0; p < producers; p++) {
+            pthread_join(ids[p], NULL);
+            busy += state[p].busy;
+            sample_count += state[p].sample_count;
+        }
+        double* samples = malloc((size_t)sample_count * sizeof(double));
+        long filled = 0;
+        for (long p = 0; p < producers; p++) {
+            memcpy(samples + filled, state[p].samples, (size_t)state[p].sample_count * sizeof(double));
+            filled += state[p].sample_count;
+            free(state[p].samples);
+        }
+        qsort(samples, (size_t)sample_count, sizeof(double), bench_compare_double);
+
+        fib_mpsc_stats_t stats = fib_mpsc_get_stats(queue);
+        printf("  %-6s %11.1f ns %11.1f ns %16.0f %10llu\n", mode ? "mpsc" : "mutex", busy * 1e9 / total,
+               samples[sample_count * 99 / 100], total / elapsed, (unsigned long long)stats.batches);
+        if (queue) {
+            printf("         largest batch %zu, %llu inserts refused on a full ring\n", stats.max_batch,
+                   (unsigned long long)stats.full);
+        }
+
+        free(samples);
+        free(ids);
+        free(state);
+        fib_mpsc_destroy(queue);
+        fib_heap_destroy(heap);
+        pthread_mutex_destroy(&lock);
+    }
+}
+
+static const benchmark_t benchmarks[] = {
+    {"core", "Core insert/decrease-key/extract-min mix", bench_core},
+    {"consolidate", "Extract-min over scattered nodes (cache behaviour)", bench_consolidate},
+    {"compact", "Drain time of a fragmented heap before and after compaction", bench_compact},
+    {"shm", "Shared-memory heap with concurrent processes", bench_shm},
+    {"stable", "Stable FIFO tie-breaking cost on duplicate-heavy keys", bench_stable},
+    {"topk", "Streaming top-K with a capacity-bounded heap", bench_topk},
+    {"dijkstra", "Dijkstra on a random graph (graph benchmark)", bench_dijkstra},
+    {"timers", "Event loop with 1M concurrent idle timeouts", bench_timers},
+    {"sched", "Work-stealing scheduler scaling, 1-64 threads", bench_sched},
+    {"peek", "Reader scalability of the published minimum under writes", bench_peek},
+    {"trace", "Operation trace recording overhead (writes a replayable trace)", bench_trace},
+    {"numa", "Node placement: malloc, arena, local and remote NUMA arenas", bench_numa},
+    {"hugepage", "Extract-min on a large heap with base versus huge-page node arenas", bench_hugepage},
+    {"drain", "Shutdown drain: extract-min loop versus fib_heap_drain_sorted", bench_drain},
+    {"cancel", "Burst of 100k cancellations: delete_node versus cancel + purge", bench_cancel},
+    {"extmem", "External-memory queue: spill/merge I/O volume, buffered and mmap runs", bench_extmem},
+    {"bucket", "Low-cardinality keys: node per item versus coalescing bucket heap", bench_bucket},
+    {"mpsc", "Insert latency and consumer throughput: mutex versus lock-free MPSC ring", bench_mpsc},
+};
+
+// Run all benchmarks, or only those named on the command line
+int main(int argc, char** argv) {
+    size_t count = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+    for (size_t i = 0; i < count; i++) {
+        bool selected = argc < 2;
+        for (int a = 1; a < argc; a++) {
+            if (strcmp(argv[a], benchmarks[i].name) == 0) {
+                selected = true;
+            }
+        }
+        if (!selected) {
+            continue;
+        }
+
+        printf("=== %s: %s ===\n", benchmarks[i].name, benchmarks[i].description);
+        benchmarks[i].run();
+        printf("\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include "fibonacci_heap.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <vector>
+
+#if __has_include(<boost/heap/fibonacci_heap.hpp>)
+#include <boost/heap/fibonacci_heap.hpp>
+#define FIB_BENCH_HAVE_BOOST 1
+#endif
+
+// Payload large enough that storing it out of line would cost a cache miss
+struct Task {
+    int priority;
+    int id;
+    std::unique_ptr<int> resource;
+
+    bool operator>(const Task& other) const { return priority > other.priority; }
+    bool operator<(const Task& other) const { return priority < other.priority; }
+};
+
+// Boost expects a max-heap comparator; std::priority_queue too
+struct TaskGreater {
+    bool operator()(const Task& a, const Task& b) const { return a.priority > b.priority; }
+};
+
+// Wall-clock time in seconds
+static double now_seconds() {
+    using clock = std::chrono::steady_clock;
+    return std::chrono::duration<double>(clock::now().time_since_epoch()).count();
+}
+
+static std::vector<int> make_keys(int n) {
+    std::vector<int> keys(n);
+    srand(42);
+    for (int& key : keys) {
+        key = rand();
+    }
+    return keys;
+}
+
+// Push n move-only tasks, then pop them all
+template <class PushFn, class PopFn>
+static double time_push_pop(const std::vector<int>& keys, PushFn push, PopFn pop) {
+    double start = now_seconds();
+    for (size_t i = 0; i < keys.size(); i++) {
+        push(Task{keys[i], (int)i, std::make_unique<int>((int)i)});
+    }
+    long checksum = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+        checksum += pop();
+    }
+    double elapsed = now_seconds() - start;
+    if (checksum == 42) {
+        printf("\n");
+    }
+    return elapsed;
+}
+
+int main() {
+    const int n = 1000000;
+    std::vector<int> keys = make_keys(n);
+
+    printf("=== Push %d move-only tasks, then pop all ===\n", n);
+
+    {
+        fib::FibonacciHeap<Task> heap;
+        double t = time_push_pop(keys,
+            [&](Task&& task) { heap.push(std::move(task)); },
+            [&]() { return heap.extract_min().id; });
+        printf("  fib::FibonacciHeap:           %8.1f ns/element\n", t * 1e9 / n);
+    }
+
+    {
+        std::priority_queue<Task, std::vector<Task>, TaskGreater> heap;
+        double t = time_push_pop(keys,
+            [&](Task&& task) { heap.push(std::move(task)); },
+            [&]() {
+                int id = heap.top().id;
+                heap.pop();
+                return id;
+            });
+        printf("  std::priority_queue:          %8.1f ns/element\n", t * 1e9 / n);
+    }
+
+#ifdef FIB_BENCH_HAVE_BOOST
+    {
+        // Boost's push() copies, so move-only payloads have to go through emplace()
+        boost::heap::fibonacci_heap<Task, boost::heap::compare<TaskGreater>> heap;
+        double t = time_push_pop(keys,
+            [&](Task&& task) { heap.emplace(std::move(task)); },
+            [&]() {
+                int id = heap.top().id;
+                heap.pop();
+                return id;
+            });
+        printf("  boost::heap::fibonacci_heap:  %8.1f ns/element\n", t * 1e9 / n);
+    }
+#else
+    printf("  boost::heap::fibonacci_heap:  (Boost headers not found, skipped)\n");
+#endif
+
+    printf("\n=== Push %d ints, decrease 10%% of keys, pop all ===\n", n);
+
+    {
+        fib::FibonacciHeap<int> heap;
+        std::vector<fib::FibonacciHeap<int>::handle> handles;
+        handles.reserve(n);
+        double start = now_seconds();
+        for (int key : keys) {
+            handles.push_back(heap.push(key));
+        }
+        for (int i = 0; i < n / 10; i++) {
+            auto h = handles[(size_t)keys[i] % n];
+            heap.decrease_key(h, *h / 2);
+        }
+        while (!heap.empty()) {
+            heap.pop();
+        }
+        printf("  fib::FibonacciHeap:           %8.1f ns/element\n", (now_seconds() - start) * 1e9 / n);
+    }
+
+#ifdef FIB_BENCH_HAVE_BOOST
+    {
+        using boost_heap = boost::heap::fibonacci_heap<int, boost::heap::compare<std::greater<int>>>;
+        boost_heap heap;
+        std::vector<boost_heap::handle_type> handles;
+        handles.reserve(n);
+        double start = now_seconds();
+        for (int key : keys) {
+            handles.push_back(heap.push(key));
+        }
+        for (int i = 0; i < n / 10; i++) {
+            auto h = handles[(size_t)keys[i] % n];
+            heap.increase(h, *h / 2);
+        }
+        while (!heap.empty()) {
+            heap.pop();
+        }
+        printf("  boost::heap::fibonacci_heap:  %8.1f ns/element\n", (now_seconds() - start) * 1e9 / n);
+    }
+#endif
+
+    return 0;
+}
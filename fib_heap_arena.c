@@ -0,0 +1,426 @@
+#define _GNU_SOURCE
+#include "fib_heap_arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Constants
+#define FIB_ARENA_DEFAULT_CHUNK (2 * 1024 * 1024)
+#define FIB_ARENA_HUGE_BYTES ((size_t)2 * 1024 * 1024)
+#define FIB_ARENA_ALIGN 16
+#define FIB_ARENA_CLASSES (FIB_ARENA_MAX_SMALL / FIB_ARENA_ALIGN)
+#define FIB_ARENA_CHUNK_HEADER 64
+#define FIB_ARENA_MAX_NODES 1024        // Size of the mbind node mask
+#define FIB_MPOL_BIND 2                 // From <linux/mempolicy.h>
+
+// Header at the start of every chunk
+typedef struct fib_arena_chunk {
+    struct fib_arena_chunk* next;
+    size_t bytes;
+    bool hugetlb;               // Mapped from the hugetlbfs pool
+} fib_arena_chunk_t;
+
+// Freed small block, linked through its first word
+typedef struct fib_arena_free {
+    struct fib_arena_free* next;
+} fib_arena_free_t;
+
+struct fib_arena {
+    int node;                   // NUMA node, or FIB_ARENA_ANY_NODE
+    fib_arena_pages_t pages;
+    size_t chunk_bytes;
+    size_t page_bytes;
+    fib_arena_chunk_t* chunks;
+    char* cursor;               // Next unused byte of the newest chunk
+    char* limit;
+    fib_arena_free_t* free_lists[FIB_ARENA_CLASSES];
+    fib_arena_stats_t stats;
+};
+
+// Helper function prototypes
+static void* fib_arena_alloc(void* user_ctx, size_t size);
+static void fib_arena_free(void* user_ctx, void* ptr, size_t size);
+static void* fib_arena_alloc_aligned(void* user_ctx, size_t alignment, size_t size);
+static void fib_arena_free_batch(void* user_ctx, void* const ptrs[], size_t count, size_t size);
+static void fib_arena_page_usage_hook(void* user_ctx, size_t* bytes, size_t* huge_bytes);
+static void* fib_arena_map(fib_arena_t* arena, size_t bytes);
+static void* fib_arena_map_aligned(fib_arena_t* arena, size_t bytes, size_t alignment);
+static void* fib_arena_map_huge(fib_arena_t* arena, size_t bytes, bool* hugetlb);
+static void fib_arena_bind(fib_arena_t* arena, void* memory, size_t bytes);
+static bool fib_arena_new_chunk(fib_arena_t* arena);
+
+// Create an arena, optionally bound to a NUMA node
+fib_arena_t* fib_arena_create(size_t chunk_bytes, int numa_node) {
+    if (numa_node < FIB_ARENA_ANY_NODE) {
+        return NULL;
+    }
+
+    fib_arena_t* arena = (fib_arena_t*)calloc(1, sizeof(fib_arena_t));
+    if (!arena) {
+        return NULL;
+    }
+
+    long page = sysconf(_SC_PAGESIZE);
+    arena->page_bytes = page > 0 ? (size_t)page : 4096;
+    if (chunk_bytes == 0) {
+        chunk_bytes = FIB_ARENA_DEFAULT_CHUNK;
+    }
+    if (chunk_bytes < FIB_ARENA_CHUNK_HEADER + FIB_ARENA_MAX_SMALL) {
+        chunk_bytes = FIB_ARENA_CHUNK_HEADER + FIB_ARENA_MAX_SMALL;
+    }
+    arena->chunk_bytes = (chunk_bytes + arena->page_bytes - 1) & ~(arena->page_bytes - 1);
+    arena->node = numa_node;
+    return arena;
+}
+
+// Unmap every chunk and free the arena
+void fib_arena_destroy(fib_arena_t* arena) {
+    if (!arena) {
+        return;
+    }
+
+    // Large blocks were unmapped by their free; only chunks remain
+    fib_arena_chunk_t* chunk = arena->chunks;
+    while (chunk) {
+        fib_arena_chunk_t* next = chunk->next;
+        munmap(chunk, chunk->bytes);
+        chunk = next;
+    }
+    free(arena);
+}
+
+// Choose base or huge pages for the arena's chunks
+fib_heap_error_t fib_arena_set_pages(fib_arena_t* arena, fib_arena_pages_t pages) {
+    if (!arena) {
+        return FIB_HEAP_ERROR_NULL_POINTER;
+    }
+
+    if (arena->stats.bytes_mapped || pages < FIB_ARENA_PAGES_BASE || pages > FIB_ARENA_PAGES_HUGETLB) {
+        return FIB_HEAP_ERROR_INVALID_STATE;
+    }
+
+    arena->pages = pages;
+    if (pages != FIB_ARENA_PAGES_BASE) {
+        arena->chunk_bytes = (arena->chunk_bytes + FIB_ARENA_HUGE_BYTES - 1) & ~(FIB_ARENA_HUGE_BYTES - 1);
+    }
+    return FIB_HEAP_SUCCESS;
+}
+
+// Get an allocator backed by the arena
+fib_heap_allocator_t fib_arena_allocator(fib_arena_t* arena) {
+    fib_heap_allocator_t allocator = {fib_arena_alloc, fib_arena_free, arena, fib_arena_alloc_aligned,
+                                      fib_arena_free_batch, fib_arena_page_usage_hook};
+    return allocator;
+}
+
+// Get the arena's NUMA node
+int fib_arena_node(fib_arena_t* arena) {
+    return arena ? arena->node : FIB_ARENA_ANY_NODE;
+}
+
+// Get arena counters
+fib_arena_stats_t fib_arena_get_stats(fib_arena_t* arena) {
+    fib_arena_stats_t stats = {0};
+    return arena ? arena->stats : stats;
+}
+
+// Measure how much of the chunk memory sits on huge pages
+void fib_arena_page_usage(fib_arena_t* arena, size_t* bytes, size_t* huge_bytes) {
+    size_t total = 0;
+    size_t huge = 0;
+    bool any_thp = false;
+
+    for (fib_arena_chunk_t* chunk = arena ? arena->chunks : NULL; chunk; chunk = chunk->next) {
+        total += chunk->bytes;
+        if (chunk->hugetlb) {
+            huge += chunk->bytes;
+        } else {
+            any_thp = true;
+        }
+    }
+
+    // THP backing is the kernel's choice: attribute each mapping's
+    // AnonHugePages to the chunks it contains, pro rata
+    FILE* smaps = any_thp ? fopen("/proc/self/smaps", "r") : NULL;
+    if (smaps) {
+        char line[256];
+        unsigned long start = 0;
+        unsigned long end = 0;
+        while (fgets(line, sizeof(line), smaps)) {
+            unsigned long a, b;
+            size_t kb;
+            if (sscanf(line, "%lx-%lx ", &a, &b) == 2) {
+                start = a;
+                end = b;
+            } else if (sscanf(line, "AnonHugePages: %zu kB", &kb) == 1 && kb && end > start) {
+                size_t overlap = 0;
+                for (fib_arena_chunk_t* chunk = arena->chunks; chunk; chunk = chunk->next) {
+                    unsigned long lo = (unsigned long)(uintptr_t)chunk;
+                    unsigned long hi = lo + chunk->bytes;
+                    if (!chunk->hugetlb && lo < end && hi > start) {
+                        overlap += (hi < end ? hi : end) - (lo > start ? lo : start);
+                    }
+                }
+                huge += (size_t)((double)kb * 1024 * overlap / (end - start));
+            }
+        }
+        fclose(smaps);
+    }
+
+    if (bytes) *bytes = total;
+    if (huge_bytes) *huge_bytes = huge < total ? huge : total;
+}
+
+// Get the number of online NUMA nodes
+int fib_numa_node_count(void) {
+    FILE* file = fopen("/sys/devices/system/node/online", "r");
+    if (!file) {
+        return 1;
+    }
+
+    // A list of ranges such as "0" or "0-1,3"; the last number is the highest node
+    int highest = 0;
+    int value;
+    while (fscanf(file, "%d", &value) == 1) {
+        highest = value;
+        if (fgetc(file) == EOF) {
+            break;
+        }
+    }
+    fclose(file);
+    return highest + 1;
+}
+
+// Get the NUMA node of the CPU the caller runs on
+int fib_numa_current_node(void) {
+#ifdef SYS_getcpu
+    unsigned int cpu = 0;
+    unsigned int node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) == 0) {
+        return (int)node;
+    }
+#endif
+    return 0;
+}
+
+// Helper function: fib_heap_allocator_t alloc
+static void* fib_arena_alloc(void* user_ctx, size_t size) {
+    fib_arena_t* arena = (fib_arena_t*)user_ctx;
+    size_t rounded = (size + FIB_ARENA_ALIGN - 1) & ~(size_t)(FIB_ARENA_ALIGN - 1);
+    if (rounded == 0) {
+        rounded = FIB_ARENA_ALIGN;
+    }
+
+    if (rounded > FIB_ARENA_MAX_SMALL) {
+        size_t bytes = (rounded + arena->page_bytes - 1) & ~(arena->page_bytes - 1);
+        void* block = fib_arena_map(arena, bytes);
+        if (block) {
+            arena->stats.bytes_in_use += rounded;
+        }
+        return block;
+    }
+
+    size_t index = rounded / FIB_ARENA_ALIGN - 1;
+    fib_arena_free_t* block = arena->free_lists[index];
+    if (block) {
+        arena->free_lists[index] = block->next;
+    } else {
+        // The tail of a full chunk is abandoned rather than split up
+        if ((size_t)(arena->limit - arena->cursor) < rounded && !fib_arena_new_chunk(arena)) {
+            return NULL;
+        }
+        block = (fib_arena_free_t*)arena->cursor;
+        arena->cursor += rounded;
+    }
+
+    arena->stats.bytes_in_use += rounded;
+    return block;
+}
+
+// Helper function: fib_heap_allocator_t free
+static void fib_arena_free(void* user_ctx, void* ptr, size_t size) {
+    fib_arena_t* arena = (fib_arena_t*)user_ctx;
+    size_t rounded = (size + FIB_ARENA_ALIGN - 1) & ~(size_t)(FIB_ARENA_ALIGN - 1);
+    if (rounded == 0) {
+        rounded = FIB_ARENA_ALIGN;
+    }
+    arena->stats.bytes_in_use -= rounded;
+
+    if (rounded > FIB_ARENA_MAX_SMALL) {
+        size_t bytes = (rounded + arena->page_bytes - 1) & ~(arena->page_bytes - 1);
+        munmap(ptr, bytes);
+        arena->stats.bytes_mapped -= bytes;
+        return;
+    }
+
+    size_t index = rounded / FIB_ARENA_ALIGN - 1;
+    fib_arena_free_t* block = (fib_arena_free_t*)ptr;
+    block->next = arena->free_lists[index];
+    arena->free_lists[index] = block;
+}
+
+// Helper function: fib_heap_allocator_t free_batch
+//
+// Small blocks of one size class are chained through their first word and
+// the chain goes onto the free list in one splice.
+static void fib_arena_free_batch(void* user_ctx, void* const ptrs[], size_t count, size_t size) {
+    fib_arena_t* arena = (fib_arena_t*)user_ctx;
+    size_t rounded = (size + FIB_ARENA_ALIGN - 1) & ~(size_t)(FIB_ARENA_ALIGN - 1);
+    if (rounded == 0) {
+        rounded = FIB_ARENA_ALIGN;
+    }
+
+    if (count == 0 || rounded > FIB_ARENA_MAX_SMALL) {
+        for (size_t i = 0; i < count; i++) {
+            fib_arena_free(user_ctx, ptrs[i], size);
+        }
+        return;
+    }
+
+    size_t index = rounded / FIB_ARENA_ALIGN - 1;
+    for (size_t i = 0; i + 1 < count; i++) {
+        ((fib_arena_free_t*)ptrs[i])->next = (fib_arena_free_t*)ptrs[i + 1];
+    }
+    ((fib_arena_free_t*)ptrs[count - 1])->next = arena->free_lists[index];
+    arena->free_lists[index] = (fib_arena_free_t*)ptrs[0];
+    arena->stats.bytes_in_use -= rounded * count;
+}
+
+// Helper function: fib_heap_allocator_t page_usage, from counters only
+static void fib_arena_page_usage_hook(void* user_ctx, size_t* bytes, size_t* huge_bytes) {
+    fib_arena_t* arena = (fib_arena_t*)user_ctx;
+    *bytes = arena->stats.bytes_mapped;
+    *huge_bytes = arena->stats.huge_page_bytes;
+}
+
+// Helper function: fib_heap_allocator_t alloc_aligned
+//
+// Only large requests (compaction's node blocks) may ask for more than the
+// size-class alignment. They get a mapping of their own, trimmed to the
+// alignment and bound like the chunks; free unmaps it as usual. Such a
+// mapping is smaller than a huge page, so it is not madvised for THP.
+static void* fib_arena_alloc_aligned(void* user_ctx, size_t alignment, size_t size) {
+    fib_arena_t* arena = (fib_arena_t*)user_ctx;
+    if (alignment <= FIB_ARENA_ALIGN) {
+        return fib_arena_alloc(user_ctx, size);
+    }
+
+    size_t rounded = (size + FIB_ARENA_ALIGN - 1) & ~(size_t)(FIB_ARENA_ALIGN - 1);
+    if (rounded <= FIB_ARENA_MAX_SMALL) {
+        return NULL;
+    }
+
+    size_t bytes = (rounded + arena->page_bytes - 1) & ~(arena->page_bytes - 1);
+    void* block = alignment <= arena->page_bytes ? fib_arena_map(arena, bytes)
+                                                 : fib_arena_map_aligned(arena, bytes, alignment);
+    if (block) {
+        arena->stats.bytes_in_use += rounded;
+    }
+    return block;
+}
+
+// Helper function: Map anonymous memory, bound to the arena's node if it has one
+static void* fib_arena_map(fib_arena_t* arena, size_t bytes) {
+    void* memory = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        return NULL;
+    }
+
+    fib_arena_bind(arena, memory, bytes);
+    arena->stats.bytes_mapped += bytes;
+    return memory;
+}
+
+// Helper function: Map a huge-page chunk, from hugetlbfs or as aligned THP memory
+static void* fib_arena_map_huge(fib_arena_t* arena, size_t bytes, bool* hugetlb) {
+    *hugetlb = false;
+
+    if (arena->pages == FIB_ARENA_PAGES_HUGETLB) {
+        void* memory = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory != MAP_FAILED) {
+            fib_arena_bind(arena, memory, bytes);
+            arena->stats.bytes_mapped += bytes;
+            arena->stats.hugetlb_chunks++;
+            arena->stats.huge_page_bytes += bytes;
+            *hugetlb = true;
+            return memory;
+        }
+        arena->stats.hugetlb_fallbacks++;
+    }
+
+    // Aligned to the huge page, so the chunk can be covered by whole huge pages
+    void* memory = fib_arena_map_aligned(arena, bytes, FIB_ARENA_HUGE_BYTES);
+#ifdef MADV_HUGEPAGE
+    if (memory && madvise(memory, bytes, MADV_HUGEPAGE) == 0) {
+        arena->stats.huge_page_bytes += bytes;
+    }
+#endif
+    return memory;
+}
+
+// Helper function: Map memory aligned to a power of two by over-mapping and trimming
+static void* fib_arena_map_aligned(fib_arena_t* arena, size_t bytes, size_t alignment) {
+    size_t span = bytes + alignment;
+    char* raw = (char*)mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == (char*)MAP_FAILED) {
+        return NULL;
+    }
+    char* memory = (char*)(((uintptr_t)raw + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    if (memory > raw) {
+        munmap(raw, memory - raw);
+    }
+    if (raw + span > memory + bytes) {
+        munmap(memory + bytes, raw + span - (memory + bytes));
+    }
+
+    fib_arena_bind(arena, memory, bytes);
+    arena->stats.bytes_mapped += bytes;
+    return memory;
+}
+
+// Helper function: Bind fresh memory to the arena's node, if it has one
+static void fib_arena_bind(fib_arena_t* arena, void* memory, size_t bytes) {
+    if (arena->node != FIB_ARENA_ANY_NODE) {
+        // Bind before anything touches the pages; they are placed on first fault
+        bool bound = false;
+#ifdef SYS_mbind
+        const size_t word_bits = 8 * sizeof(unsigned long);
+        unsigned long mask[FIB_ARENA_MAX_NODES / (8 * sizeof(unsigned long))] = {0};
+        if (arena->node < FIB_ARENA_MAX_NODES) {
+            mask[arena->node / word_bits] |= 1UL << (arena->node % word_bits);
+            // The kernel reads maxnode - 1 bits of the mask
+            bound = syscall(SYS_mbind, memory, bytes, FIB_MPOL_BIND, mask,
+                            (unsigned long)FIB_ARENA_MAX_NODES + 1, 0) == 0;
+        }
+#else
+        (void)memory;
+        (void)bytes;
+#endif
+        if (!bound) {
+            arena->stats.unbound_mappings++;
+        }
+    }
+}
+
+// Helper function: Start a fresh chunk for small blocks
+static bool fib_arena_new_chunk(fib_arena_t* arena) {
+    bool hugetlb = false;
+    fib_arena_chunk_t* chunk = (fib_arena_chunk_t*)(arena->pages == FIB_ARENA_PAGES_BASE
+        ? fib_arena_map(arena, arena->chunk_bytes)
+        : fib_arena_map_huge(arena, arena->chunk_bytes, &hugetlb));
+    if (!chunk) {
+        return false;
+    }
+
+    chunk->next = arena->chunks;
+    chunk->bytes = arena->chunk_bytes;
+    chunk->hugetlb = hugetlb;
+    arena->chunks = chunk;
+    arena->cursor = (char*)chunk + FIB_ARENA_CHUNK_HEADER;
+    arena->limit = (char*)chunk + arena->chunk_bytes;
+    arena->stats.chunks++;
+    return true;
+}
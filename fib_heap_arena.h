@@ -0,0 +1,86 @@
+#ifndef FIB_HEAP_ARENA_H
+#define FIB_HEAP_ARENA_H
+
+#include "fibonacci_heap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Arena and NUMA-local allocators for fib_heap_create_with_allocator.
+//
+// An arena carves allocations out of large mmap'd chunks and keeps freed
+// blocks on per-size free lists. The allocator's sized free tells it the
+// size class, so blocks carry no header and a heap's nodes stay packed.
+// Requests above FIB_ARENA_MAX_SMALL get a mapping of their own.
+//
+// An arena created for a NUMA node binds every mapping to that node with
+// mbind(2) before first touch, so the pages land there whichever thread
+// faults them in. Where binding is unavailable (no NUMA support, an offline
+// node, a seccomp filter) the memory is used unbound and counted in
+// unbound_mappings. Memory returns to the system only on destroy. An arena
+// is not thread-safe: heaps sharing one must be mutated under a common lock.
+//
+// For very large heaps the chunks can be backed by 2 MiB pages, so the
+// pointer chasing of consolidate misses the TLB far less. Chunks are then
+// exactly 2 MiB and 2 MiB-aligned; FIB_ARENA_PAGES_THP asks for transparent
+// huge pages with MADV_HUGEPAGE, FIB_ARENA_PAGES_HUGETLB maps explicit
+// hugetlbfs pages and falls back to THP, chunk by chunk, when the pool is
+// empty. fib_heap_get_statistics reports the chunk bytes placed on huge
+// pages from counters the arena keeps: hugetlbfs chunks and chunks madvised
+// for THP. The kernel may still back THP chunks with base pages; what it
+// actually did is measured from /proc/self/smaps by fib_arena_page_usage.
+
+#define FIB_ARENA_ANY_NODE (-1)
+#define FIB_ARENA_MAX_SMALL 1024
+
+typedef struct fib_arena fib_arena_t;
+
+// Page size backing the arena's chunks
+typedef enum {
+    FIB_ARENA_PAGES_BASE = 0,   // Regular pages (default)
+    FIB_ARENA_PAGES_THP,        // Transparent huge pages (MADV_HUGEPAGE)
+    FIB_ARENA_PAGES_HUGETLB     // MAP_HUGETLB, THP when no huge page is free
+} fib_arena_pages_t;
+
+// Arena counters
+typedef struct {
+    size_t chunks;              // Chunks mapped for small blocks
+    size_t bytes_mapped;        // All mapped bytes, chunks and large blocks
+    size_t bytes_in_use;        // Bytes currently handed out
+    size_t unbound_mappings;    // Mappings left unbound after mbind failed
+    size_t hugetlb_chunks;      // Chunks mapped from the hugetlbfs pool
+    size_t hugetlb_fallbacks;   // HUGETLB chunks that fell back to THP
+    size_t huge_page_bytes;     // Chunk bytes from hugetlbfs or madvised for THP
+} fib_arena_stats_t;
+
+// Arena creation and destruction (chunk_bytes 0 picks 2 MiB). Destroy frees
+// everything at once; heaps using the arena must be destroyed first.
+fib_arena_t* fib_arena_create(size_t chunk_bytes, int numa_node);
+void fib_arena_destroy(fib_arena_t* arena);
+
+// Choose the page size; only allowed before the first allocation
+fib_heap_error_t fib_arena_set_pages(fib_arena_t* arena, fib_arena_pages_t pages);
+
+// Allocator handing out the arena's memory
+fib_heap_allocator_t fib_arena_allocator(fib_arena_t* arena);
+
+// Status inquiry
+int fib_arena_node(fib_arena_t* arena);
+fib_arena_stats_t fib_arena_get_stats(fib_arena_t* arena);
+
+// Bytes of chunk memory and how many of them are on huge pages. THP backing
+// is read from /proc/self/smaps, so this costs a file parse per call; the
+// statistics of an arena-backed heap use the cheap counters instead.
+void fib_arena_page_usage(fib_arena_t* arena, size_t* bytes, size_t* huge_bytes);
+
+// NUMA topology: number of online nodes (1 when unknown) and the node of
+// the calling thread's CPU (0 when unknown)
+int fib_numa_node_count(void);
+int fib_numa_current_node(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIB_HEAP_ARENA_H
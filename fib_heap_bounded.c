@@ -0,0 +1,180 @@
+#include "fib_heap_bounded.h"
+#include <stdlib.h>
+
+// Entry shared by the min-ordered and max-ordered twin nodes
+typedef struct {
+    int key;
+    void* data;
+    fib_node_t* min_node;       // Node in the best-first heap
+    fib_node_t* max_node;       // Node in the worst-first heap
+} fib_bounded_entry_t;
+
+struct fib_bounded_heap {
+    fib_heap_t* best;           // Ordered by key
+    fib_heap_t* worst;          // Ordered by ~key (reverses order without overflow)
+    size_t capacity;
+};
+
+// Helper function prototypes
+static fib_bounded_item_t fib_bounded_item_from(fib_bounded_entry_t* entry);
+static fib_bounded_entry_t* fib_bounded_pop_worst(fib_bounded_heap_t* heap);
+static fib_bounded_entry_t* fib_bounded_pop_best(fib_bounded_heap_t* heap);
+
+// Create a bounded heap holding at most capacity items
+fib_bounded_heap_t* fib_bounded_heap_create(size_t capacity) {
+    if (capacity == 0) {
+        return NULL;
+    }
+
+    fib_bounded_heap_t* heap = (fib_bounded_heap_t*)malloc(sizeof(fib_bounded_heap_t));
+    if (!heap) {
+        return NULL;
+    }
+
+    heap->best = fib_heap_create();
+    heap->worst = fib_heap_create();
+    if (!heap->best || !heap->worst) {
+        fib_heap_destroy(heap->best);
+        fib_heap_destroy(heap->worst);
+        free(heap);
+        return NULL;
+    }
+
+    heap->capacity = capacity;
+    return heap;
+}
+
+// Destroy the bounded heap and its entries
+void fib_bounded_heap_destroy(fib_bounded_heap_t* heap) {
+    if (!heap) {
+        return;
+    }
+
+    // Entries are only reachable through node data, so free them via one twin
+    fib_node_t* node;
+    while ((node = fib_heap_extract_min(heap->worst)) != NULL) {
+        free(node->data);
+        free(node);
+    }
+
+    fib_heap_destroy(heap->best);
+    fib_heap_destroy(heap->worst);
+    free(heap);
+}
+
+// Offer an item to the bounded heap
+fib_heap_error_t fib_bounded_heap_insert(fib_bounded_heap_t* heap, int key, void* data,
+                                         bool* kept, fib_bounded_item_t* evicted) {
+    if (kept) *kept = false;
+    if (evicted) evicted->valid = false;
+
+    if (!heap) {
+        return FIB_HEAP_ERROR_NULL_POINTER;
+    }
+
+    // Fast rejection: not better than the current worst of a full heap
+    bool full = fib_heap_size(heap->best) >= heap->capacity;
+    if (full && key >= ~fib_heap_minimum(heap->worst)->key) {
+        return FIB_HEAP_SUCCESS;
+    }
+
+    fib_bounded_entry_t* entry = (fib_bounded_entry_t*)malloc(sizeof(fib_bounded_entry_t));
+    if (!entry) {
+        return FIB_HEAP_ERROR_OUT_OF_MEMORY;
+    }
+    entry->key = key;
+    entry->data = data;
+    entry->min_node = fib_heap_insert(heap->best, key, entry);
+    entry->max_node = entry->min_node ? fib_heap_insert(heap->worst, ~key, entry) : NULL;
+    if (!entry->max_node) {
+        if (entry->min_node) {
+            fib_heap_delete_node(heap->best, entry->min_node);
+        }
+        free(entry);
+        return FIB_HEAP_ERROR_OUT_OF_MEMORY;
+    }
+
+    if (full) {
+        fib_bounded_entry_t* victim = fib_bounded_pop_worst(heap);
+        if (evicted) *evicted = fib_bounded_item_from(victim);
+        free(victim);
+    }
+
+    if (kept) *kept = true;
+    return FIB_HEAP_SUCCESS;
+}
+
+// Get the best (smallest key) item without removing it
+fib_bounded_item_t fib_bounded_heap_best(fib_bounded_heap_t* heap) {
+    fib_node_t* node = heap ? fib_heap_minimum(heap->best) : NULL;
+    return fib_bounded_item_from(node ? (fib_bounded_entry_t*)node->data : NULL);
+}
+
+// Get the worst (largest key) item without removing it
+fib_bounded_item_t fib_bounded_heap_worst(fib_bounded_heap_t* heap) {
+    fib_node_t* node = heap ? fib_heap_minimum(heap->worst) : NULL;
+    return fib_bounded_item_from(node ? (fib_bounded_entry_t*)node->data : NULL);
+}
+
+// Remove and return the best item
+fib_bounded_item_t fib_bounded_heap_extract_best(fib_bounded_heap_t* heap) {
+    fib_bounded_entry_t* entry = heap ? fib_bounded_pop_best(heap) : NULL;
+    fib_bounded_item_t item = fib_bounded_item_from(entry);
+    free(entry);
+    return item;
+}
+
+// Remove and return the worst item
+fib_bounded_item_t fib_bounded_heap_extract_worst(fib_bounded_heap_t* heap) {
+    fib_bounded_entry_t* entry = heap ? fib_bounded_pop_worst(heap) : NULL;
+    fib_bounded_item_t item = fib_bounded_item_from(entry);
+    free(entry);
+    return item;
+}
+
+// Get number of items held
+size_t fib_bounded_heap_size(fib_bounded_heap_t* heap) {
+    return heap ? fib_heap_size(heap->best) : 0;
+}
+
+// Get maximum number of items held
+size_t fib_bounded_heap_capacity(fib_bounded_heap_t* heap) {
+    return heap ? heap->capacity : 0;
+}
+
+// Helper function: Copy an entry out as an item
+static fib_bounded_item_t fib_bounded_item_from(fib_bounded_entry_t* entry) {
+    fib_bounded_item_t item = {0, NULL, false};
+    if (entry) {
+        item.key = entry->key;
+        item.data = entry->data;
+        item.valid = true;
+    }
+    return item;
+}
+
+// Helper function: Unlink the worst entry from both twins; caller frees it
+static fib_bounded_entry_t* fib_bounded_pop_worst(fib_bounded_heap_t* heap) {
+    fib_node_t* node = fib_heap_extract_min(heap->worst);
+    if (!node) {
+        return NULL;
+    }
+
+    fib_bounded_entry_t* entry = (fib_bounded_entry_t*)node->data;
+    free(node);
+    fib_heap_delete_node(heap->best, entry->min_node);
+    return entry;
+}
+
+// Helper function: Unlink the best entry from both twins; caller frees it
+static fib_bounded_entry_t* fib_bounded_pop_best(fib_bounded_heap_t* heap) {
+    fib_node_t* node = fib_heap_extract_min(heap->best);
+    if (!node) {
+        return NULL;
+    }
+
+    fib_bounded_entry_t* entry = (fib_bounded_entry_t*)node->data;
+    free(node);
+    fib_heap_delete_node(heap->worst, entry->max_node);
+    return entry;
+}
@@ -0,0 +1,50 @@
+#ifndef FIB_HEAP_BOUNDED_H
+#define FIB_HEAP_BOUNDED_H
+
+#include "fibonacci_heap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Capacity-bounded heap for streaming top-K.
+//
+// Keeps at most `capacity` items, where smaller keys are better. Items are
+// held in two Fibonacci heaps over the same entries: a min-ordered heap for
+// the best item and a max-ordered twin for the worst one, so the eviction
+// candidate is always available in O(1). Rejecting an item that is no better
+// than the current worst costs a single comparison.
+
+typedef struct fib_bounded_heap fib_bounded_heap_t;
+
+// Item pushed out (or popped) by a bounded heap operation
+typedef struct {
+    int key;
+    void* data;
+    bool valid;                 // False when no item was produced
+} fib_bounded_item_t;
+
+// Heap creation and destruction
+fib_bounded_heap_t* fib_bounded_heap_create(size_t capacity);
+void fib_bounded_heap_destroy(fib_bounded_heap_t* heap);
+
+// Offer an item. *kept reports whether it entered the heap; if the heap was
+// full, the displaced worst item is returned through evicted (may be NULL).
+fib_heap_error_t fib_bounded_heap_insert(fib_bounded_heap_t* heap, int key, void* data,
+                                         bool* kept, fib_bounded_item_t* evicted);
+
+// Best / worst access
+fib_bounded_item_t fib_bounded_heap_best(fib_bounded_heap_t* heap);
+fib_bounded_item_t fib_bounded_heap_worst(fib_bounded_heap_t* heap);
+fib_bounded_item_t fib_bounded_heap_extract_best(fib_bounded_heap_t* heap);
+fib_bounded_item_t fib_bounded_heap_extract_worst(fib_bounded_heap_t* heap);
+
+// Status inquiry
+size_t fib_bounded_heap_size(fib_bounded_heap_t* heap);
+size_t fib_bounded_heap_capacity(fib_bounded_heap_t* heap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIB_HEAP_BOUNDED_H
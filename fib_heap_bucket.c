@@ -0,0 +1,214 @@
+#include "fib_heap_bucket.h"
+#include "fib_heap_hash.h"
+#include <stdlib.h>
+
+// Constants
+#define FIB_BUCKET_CHUNK 62             // Payloads per chunk; 512 bytes with the link and malloc header
+
+// Fixed-size piece of a bucket's FIFO
+typedef struct fib_bucket_chunk {
+    struct fib_bucket_chunk* next;
+    void* items[FIB_BUCKET_CHUNK];
+} fib_bucket_chunk_t;
+
+// Payloads of one key, oldest first
+typedef struct {
+    int key;
+    fib_node_t* node;           // The key's node in the forest
+    fib_bucket_chunk_t* first;  // Popped from at first_pos
+    fib_bucket_chunk_t* last;   // Appended to at last_pos
+    size_t first_pos;
+    size_t last_pos;
+} fib_bucket_t;
+
+// Table entry: a key's bucket
+typedef struct {
+    fib_hash_entry_t entry;     // Keyed by the key's 32-bit pattern
+    fib_bucket_t* bucket;
+} fib_bucket_slot_t;
+
+struct fib_bucket_heap {
+    fib_heap_t* forest;         // One node per distinct key, data is the bucket
+    fib_hash_table_t table;     // Key to bucket
+    size_t size;                // Items in all buckets
+    fib_bucket_chunk_t* spare;  // Recycled chunks
+};
+
+// Helper function prototypes
+static inline fib_bucket_slot_t* fib_bucket_find(fib_bucket_heap_t* heap, int key);
+static fib_bucket_chunk_t* fib_bucket_chunk_get(fib_bucket_heap_t* heap);
+static void fib_bucket_chunk_put(fib_bucket_heap_t* heap, fib_bucket_chunk_t* chunk);
+
+// Create a coalescing heap
+fib_bucket_heap_t* fib_bucket_heap_create(void) {
+    fib_bucket_heap_t* heap = (fib_bucket_heap_t*)calloc(1, sizeof(fib_bucket_heap_t));
+    if (!heap) {
+        return NULL;
+    }
+
+    heap->forest = fib_heap_create();
+    if (!heap->forest) {
+        free(heap);
+        return NULL;
+    }
+
+    fib_hash_init(&heap->table, sizeof(fib_bucket_slot_t));
+    return heap;
+}
+
+// Destroy the heap, its buckets and chunks (payloads are not freed)
+void fib_bucket_heap_destroy(fib_bucket_heap_t* heap) {
+    if (!heap) {
+        return;
+    }
+
+    for (size_t i = 0; i < heap->table.capacity; i++) {
+        fib_bucket_slot_t* slot = (fib_bucket_slot_t*)fib_hash_slot(&heap->table, i);
+        if (slot->entry.used) {
+            fib_bucket_t* bucket = slot->bucket;
+            fib_bucket_chunk_t* chunk = bucket->first;
+            while (chunk) {
+                fib_bucket_chunk_t* next = chunk->next;
+                free(chunk);
+                chunk = next;
+            }
+            free(bucket);
+        }
+    }
+    while (heap->spare) {
+        fib_bucket_chunk_t* next = heap->spare->next;
+        free(heap->spare);
+        heap->spare = next;
+    }
+
+    fib_heap_destroy(heap->forest);
+    fib_hash_free(&heap->table);
+    free(heap);
+}
+
+// Insert an item; an existing key only appends to its bucket
+fib_heap_error_t fib_bucket_heap_insert(fib_bucket_heap_t* heap, int key, void* data) {
+    if (!heap) {
+        return FIB_HEAP_ERROR_NULL_POINTER;
+    }
+
+    fib_bucket_slot_t* slot = fib_bucket_find(heap, key);
+    fib_bucket_t* bucket = slot ? slot->bucket : NULL;
+
+    if (bucket && bucket->last_pos == FIB_BUCKET_CHUNK) {
+        fib_bucket_chunk_t* chunk = fib_bucket_chunk_get(heap);
+        if (!chunk) {
+            return FIB_HEAP_ERROR_OUT_OF_MEMORY;
+        }
+        bucket->last->next = chunk;
+        bucket->last = chunk;
+        bucket->last_pos = 0;
+    }
+
+    if (!bucket) {
+        if (!fib_hash_reserve(&heap->table, 1)) {
+            return FIB_HEAP_ERROR_OUT_OF_MEMORY;
+        }
+
+        bucket = (fib_bucket_t*)malloc(sizeof(fib_bucket_t));
+        fib_bucket_chunk_t* chunk = bucket ? fib_bucket_chunk_get(heap) : NULL;
+        fib_node_t* node = chunk ? fib_heap_insert(heap->forest, key, bucket) : NULL;
+        if (!node) {
+            if (chunk) {
+                fib_bucket_chunk_put(heap, chunk);
+            }
+            free(bucket);
+            return FIB_HEAP_ERROR_OUT_OF_MEMORY;
+        }
+
+        bucket->key = key;
+        bucket->node = node;
+        bucket->first = bucket->last = chunk;
+        bucket->first_pos = bucket->last_pos = 0;
+        slot = (fib_bucket_slot_t*)fib_hash_add(&heap->table, (uint32_t)key);
+        slot->bucket = bucket;
+    }
+
+    bucket->last->items[bucket->last_pos++] = data;
+    heap->size++;
+    return FIB_HEAP_SUCCESS;
+}
+
+// Get the oldest item with the smallest key without removing it
+fib_bucket_item_t fib_bucket_heap_minimum(fib_bucket_heap_t* heap) {
+    fib_bucket_item_t item = {0, NULL, false};
+    fib_node_t* node = heap ? fib_heap_minimum(heap->forest) : NULL;
+    if (node) {
+        fib_bucket_t* bucket = (fib_bucket_t*)node->data;
+        item.key = bucket->key;
+        item.data = bucket->first->items[bucket->first_pos];
+        item.valid = true;
+    }
+    return item;
+}
+
+// Remove and return the oldest item with the smallest key
+//
+// The forest is only touched when this empties the minimum's bucket.
+fib_bucket_item_t fib_bucket_heap_extract_min(fib_bucket_heap_t* heap) {
+    fib_bucket_item_t item = {0, NULL, false};
+    fib_node_t* node = heap ? fib_heap_minimum(heap->forest) : NULL;
+    if (!node) {
+        return item;
+    }
+
+    fib_bucket_t* bucket = (fib_bucket_t*)node->data;
+    item.key = bucket->key;
+    item.data = bucket->first->items[bucket->first_pos++];
+    item.valid = true;
+    heap->size--;
+
+    if (bucket->first == bucket->last && bucket->first_pos == bucket->last_pos) {
+        fib_heap_free_node(heap->forest, fib_heap_extract_min(heap->forest));
+        fib_bucket_chunk_put(heap, bucket->first);
+        fib_hash_erase(&heap->table, &fib_bucket_find(heap, bucket->key)->entry);
+        free(bucket);
+    } else if (bucket->first_pos == FIB_BUCKET_CHUNK) {
+        fib_bucket_chunk_t* done = bucket->first;
+        bucket->first = done->next;
+        bucket->first_pos = 0;
+        fib_bucket_chunk_put(heap, done);
+    }
+    return item;
+}
+
+// Get number of items
+size_t fib_bucket_heap_size(fib_bucket_heap_t* heap) {
+    return heap ? heap->size : 0;
+}
+
+// Get number of distinct keys (nodes in the forest)
+size_t fib_bucket_heap_distinct_keys(fib_bucket_heap_t* heap) {
+    return heap ? fib_heap_size(heap->forest) : 0;
+}
+
+// Helper function: The key's table entry, or NULL
+static inline fib_bucket_slot_t* fib_bucket_find(fib_bucket_heap_t* heap, int key) {
+    return (fib_bucket_slot_t*)fib_hash_find(&heap->table, (uint32_t)key);
+}
+
+// Helper function: Take a chunk from the spare list or allocate one
+static fib_bucket_chunk_t* fib_bucket_chunk_get(fib_bucket_heap_t* heap) {
+    fib_bucket_chunk_t* chunk = heap->spare;
+    if (chunk) {
+        heap->spare = chunk->next;
+    } else {
+        chunk = (fib_bucket_chunk_t*)malloc(sizeof(fib_bucket_chunk_t));
+        if (!chunk) {
+            return NULL;
+        }
+    }
+    chunk->next = NULL;
+    return chunk;
+}
+
+// Helper function: Keep an emptied chunk for reuse
+static void fib_bucket_chunk_put(fib_bucket_heap_t* heap, fib_bucket_chunk_t* chunk) {
+    chunk->next = heap->spare;
+    heap->spare = chunk;
+}
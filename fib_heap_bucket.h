@@ -0,0 +1,47 @@
+#ifndef FIB_HEAP_BUCKET_H
+#define FIB_HEAP_BUCKET_H
+
+#include "fibonacci_heap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Coalescing heap for workloads with few distinct keys.
+//
+// Items with equal keys share one Fibonacci heap node, whose data is a FIFO
+// bucket of their payloads. A small hash table finds the bucket of a key,
+// so inserting under a key that is already present is an append, and
+// extract-min pops from the minimum's bucket without touching the forest.
+// Only when a key appears or its bucket empties is a node inserted or
+// extracted, so the forest holds one node per distinct key rather than
+// one per item. Equal keys come out in insertion order. Items have no
+// handles: there is no decrease-key or delete.
+
+typedef struct fib_bucket_heap fib_bucket_heap_t;
+
+// Item returned by a bucket heap operation
+typedef struct {
+    int key;
+    void* data;
+    bool valid;                 // False when the heap was empty
+} fib_bucket_item_t;
+
+// Heap creation and destruction
+fib_bucket_heap_t* fib_bucket_heap_create(void);
+void fib_bucket_heap_destroy(fib_bucket_heap_t* heap);
+
+// Heap operations
+fib_heap_error_t fib_bucket_heap_insert(fib_bucket_heap_t* heap, int key, void* data);
+fib_bucket_item_t fib_bucket_heap_minimum(fib_bucket_heap_t* heap);
+fib_bucket_item_t fib_bucket_heap_extract_min(fib_bucket_heap_t* heap);
+
+// Status inquiry
+size_t fib_bucket_heap_size(fib_bucket_heap_t* heap);
+size_t fib_bucket_heap_distinct_keys(fib_bucket_heap_t* heap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIB_HEAP_BUCKET_H
@@ -0,0 +1,435 @@
+#define _GNU_SOURCE
+#include "fib_heap_event_loop.h"
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+// Constants
+#define FIB_LOOP_MAX_EVENTS 64
+#define FIB_LOOP_MAX_TIMEOUT_MS ((uint32_t)(INT_MAX / 2))
+#define FIB_LOOP_REBASE_MS ((uint64_t)(INT_MAX / 2))
+
+struct fib_timer {
+    fib_node_t* node;           // Heap node, NULL once taken for dispatch
+    fib_timer_fn callback;
+    void* user_ctx;
+    bool cancelled;             // Cancelled while waiting in a dispatch batch
+};
+
+// Registered file descriptor
+typedef struct fib_io_watch {
+    int fd;
+    fib_io_fn callback;         // NULL once removed
+    void* user_ctx;
+    struct fib_io_watch* next_retired;
+} fib_io_watch_t;
+
+struct fib_event_loop {
+    int epoll_fd;
+    int timer_fd;
+    struct timespec base;       // CLOCK_MONOTONIC at creation
+
+    fib_heap_t* timers;         // Keyed by deadline - key_base_ms
+    uint64_t key_base_ms;       // Offset that keeps keys within int range
+    bool armed;                 // timerfd currently armed
+    int armed_key;              // Key the timerfd is armed for
+
+    fib_timer_t** batch;        // Expired timers awaiting their callbacks
+    size_t batch_capacity;
+    bool dispatching;
+
+    fib_io_watch_t** watches;   // Indexed by fd
+    size_t watch_capacity;
+    fib_io_watch_t* retired;    // Removed during dispatch, freed afterwards
+
+    bool stopped;
+    fib_event_loop_stats_t stats;
+};
+
+// Helper function prototypes
+static uint64_t fib_loop_elapsed_ms(const struct timespec* base);
+static void fib_loop_rearm(fib_event_loop_t* loop);
+static void fib_loop_rebase(fib_event_loop_t* loop, uint64_t now_ms);
+static void fib_loop_dispatch_timers(fib_event_loop_t* loop);
+
+// Create an event loop
+fib_event_loop_t* fib_event_loop_create(void) {
+    fib_event_loop_t* loop = (fib_event_loop_t*)calloc(1, sizeof(fib_event_loop_t));
+    if (!loop) {
+        return NULL;
+    }
+
+    loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    loop->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    loop->timers = fib_heap_create();
+    if (loop->epoll_fd < 0 || loop->timer_fd < 0 || !loop->timers) {
+        fib_event_loop_destroy(loop);
+        return NULL;
+    }
+
+    // The timerfd is recognised by a data pointer equal to the loop itself
+    struct epoll_event event = {0};
+    event.events = EPOLLIN;
+    event.data.ptr = loop;
+    if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, loop->timer_fd, &event) != 0) {
+        fib_event_loop_destroy(loop);
+        return NULL;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &loop->base);
+    return loop;
+}
+
+// Destroy the event loop, dropping pending timers without running them
+void fib_event_loop_destroy(fib_event_loop_t* loop) {
+    if (!loop) {
+        return;
+    }
+
+    if (loop->timers) {
+        fib_node_t* node;
+        while ((node = fib_heap_extract_min(loop->timers)) != NULL) {
+            free(node->data);
+            fib_heap_free_node(loop->timers, node);
+        }
+        fib_heap_destroy(loop->timers);
+    }
+
+    for (size_t fd = 0; fd < loop->watch_capacity; fd++) {
+        free(loop->watches[fd]);
+    }
+    free(loop->watches);
+    free(loop->batch);
+
+    if (loop->timer_fd >= 0) close(loop->timer_fd);
+    if (loop->epoll_fd >= 0) close(loop->epoll_fd);
+    free(loop);
+}
+
+// Schedule a one-shot timer
+fib_timer_t* fib_event_loop_add_timer(fib_event_loop_t* loop, uint32_t timeout_ms,
+                                      fib_timer_fn callback, void* user_ctx) {
+    if (!loop || !callback || timeout_ms > FIB_LOOP_MAX_TIMEOUT_MS) {
+        return NULL;
+    }
+
+    uint64_t now_ms = fib_loop_elapsed_ms(&loop->base);
+    if (now_ms - loop->key_base_ms > FIB_LOOP_REBASE_MS) {
+        fib_loop_rebase(loop, now_ms);
+    }
+
+    fib_timer_t* timer = (fib_timer_t*)malloc(sizeof(fib_timer_t));
+    if (!timer) {
+        return NULL;
+    }
+    timer->callback = callback;
+    timer->user_ctx = user_ctx;
+    timer->cancelled = false;
+
+    int key = (int)(now_ms - loop->key_base_ms + timeout_ms);
+    timer->node = fib_heap_insert(loop->timers, key, timer);
+    if (!timer->node) {
+        free(timer);
+        return NULL;
+    }
+
+    if (!loop->dispatching) {
+        fib_loop_rearm(loop);
+    }
+    return timer;
+}
+
+// Cancel a timer that has not fired yet
+fib_heap_error_t fib_event_loop_cancel_timer(fib_event_loop_t* loop, fib_timer_t* timer) {
+    if (!loop || !timer) {
+        return FIB_HEAP_ERROR_NULL_POINTER;
+    }
+
+    if (!timer->node) {
+        // Already taken for dispatch; skip its callback and free it with the batch
+        if (!loop->dispatching || timer->cancelled) {
+            return FIB_HEAP_ERROR_INVALID_HANDLE;
+        }
+        timer->cancelled = true;
+        return FIB_HEAP_SUCCESS;
+    }
+
+    fib_heap_error_t result = fib_heap_delete_node(loop->timers, timer->node);
+    if (result != FIB_HEAP_SUCCESS) {
+        return result;
+    }
+    free(timer);
+
+    if (!loop->dispatching) {
+        fib_loop_rearm(loop);
+    }
+    return FIB_HEAP_SUCCESS;
+}
+
+// Watch a file descriptor
+fib_heap_error_t fib_event_loop_add_fd(fib_event_loop_t* loop, int fd, uint32_t events,
+                                       fib_io_fn callback, void* user_ctx) {
+    if (!loop || !callback) {
+        return FIB_HEAP_ERROR_NULL_POINTER;
+    }
+    if (fd < 0) {
+        return FIB_HEAP_ERROR_INVALID_HANDLE;
+    }
+
+    if ((size_t)fd >= loop->watch_capacity) {
+        size_t capacity = loop->watch_capacity ? loop->watch_capacity : 16;
+        while (capacity <= (size_t)fd) {
+            capacity *= 2;
+        }
+        fib_io_watch_t** grown = (fib_io_watch_t**)realloc(loop->watches, capacity * sizeof(fib_io_watch_t*));
+        if (!grown) {
+            return FIB_HEAP_ERROR_OUT_OF_MEMORY;
+        }
+        for (size_t i = loop->watch_capacity; i < capacity; i++) {
+            grown[i] = NULL;
+        }
+        loop->watches = grown;
+        loop->watch_capacity = capacity;
+    }
+    if (loop->watches[fd]) {
+        return FIB_HEAP_ERROR_INVALID_STATE;
+    }
+
+    fib_io_watch_t* watch = (fib_io_watch_t*)malloc(sizeof(fib_io_watch_t));
+    if (!watch) {
+        return FIB_HEAP_ERROR_OUT_OF_MEMORY;
+    }
+    watch->fd = fd;
+    watch->callback = callback;
+    watch->user_ctx = user_ctx;
+
+    struct epoll_event event = {0};
+    event.events = events;
+    event.data.ptr = watch;
+    if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+        free(watch);
+        return FIB_HEAP_ERROR_INVALID_HANDLE;
+    }
+
+    loop->watches[fd] = watch;
+    return FIB_HEAP_SUCCESS;
+}
+
+// Stop watching a file descriptor
+fib_heap_error_t fib_event_loop_remove_fd(fib_event_loop_t* loop, int fd) {
+    if (!loop) {
+        return FIB_HEAP_ERROR_NULL_POINTER;
+    }
+    if (fd < 0 || (size_t)fd >= loop->watch_capacity || !loop->watches[fd]) {
+        return FIB_HEAP_ERROR_INVALID_HANDLE;
+    }
+
+    epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+
+    // Events already returned by this epoll_wait may still name the watch;
+    // clearing the callback makes run_once skip them until it is freed
+    fib_io_watch_t* watch = loop->watches[fd];
+    loop->watches[fd] = NULL;
+    if (loop->dispatching) {
+        watch->callback = NULL;
+        watch->next_retired = loop->retired;
+        loop->retired = watch;
+    } else {
+        free(watch);
+    }
+    return FIB_HEAP_SUCCESS;
+}
+
+// Wait for events once and dispatch them; returns the number of wakeup events
+int fib_event_loop_run_once(fib_event_loop_t* loop, int max_wait_ms) {
+    if (!loop) {
+        return -1;
+    }
+
+    struct epoll_event events[FIB_LOOP_MAX_EVENTS];
+    int count = epoll_wait(loop->epoll_fd, events, FIB_LOOP_MAX_EVENTS, max_wait_ms);
+    if (count < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+    loop->stats.wakeups++;
+
+    loop->dispatching = true;
+
+    for (int i = 0; i < count; i++) {
+        if (events[i].data.ptr == loop) {
+            uint64_t expirations;
+            ssize_t ignored = read(loop->timer_fd, &expirations, sizeof(expirations));
+            (void)ignored;
+            loop->armed = false;
+            continue;
+        }
+
+        fib_io_watch_t* watch = (fib_io_watch_t*)events[i].data.ptr;
+        if (watch->callback) {
+            watch->callback(loop, watch->fd, events[i].events, watch->user_ctx);
+        }
+    }
+
+    fib_loop_dispatch_timers(loop);
+    loop->dispatching = false;
+
+    // Watches removed during dispatch are freed once no event can name them
+    while (loop->retired) {
+        fib_io_watch_t* next = loop->retired->next_retired;
+        free(loop->retired);
+        loop->retired = next;
+    }
+
+    fib_loop_rearm(loop);
+    return count;
+}
+
+// Run until fib_event_loop_stop is called
+void fib_event_loop_run(fib_event_loop_t* loop) {
+    if (!loop) {
+        return;
+    }
+
+    loop->stopped = false;
+    while (!loop->stopped) {
+        if (fib_event_loop_run_once(loop, -1) < 0) {
+            break;
+        }
+    }
+}
+
+void fib_event_loop_stop(fib_event_loop_t* loop) {
+    if (loop) {
+        loop->stopped = true;
+    }
+}
+
+// Milliseconds since the loop was created
+uint64_t fib_event_loop_now_ms(fib_event_loop_t* loop) {
+    return loop ? fib_loop_elapsed_ms(&loop->base) : 0;
+}
+
+// Get loop counters
+fib_event_loop_stats_t fib_event_loop_get_stats(fib_event_loop_t* loop) {
+    fib_event_loop_stats_t stats = {0};
+    if (loop) {
+        stats = loop->stats;
+        stats.pending_timers = fib_heap_size(loop->timers);
+    }
+    return stats;
+}
+
+// Helper function: Milliseconds elapsed since base
+static uint64_t fib_loop_elapsed_ms(const struct timespec* base) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t ns = (int64_t)(now.tv_sec - base->tv_sec) * 1000000000LL + (now.tv_nsec - base->tv_nsec);
+    return (uint64_t)(ns / 1000000);
+}
+
+// Helper function: Point the timerfd at the earliest deadline if it changed
+static void fib_loop_rearm(fib_event_loop_t* loop) {
+    fib_node_t* min = fib_heap_minimum(loop->timers);
+    struct itimerspec spec = {{0, 0}, {0, 0}};
+
+    if (!min) {
+        if (!loop->armed) {
+            return;
+        }
+        loop->armed = false;
+    } else {
+        if (loop->armed && loop->armed_key == min->key) {
+            return;
+        }
+
+        // Absolute expiry; a zero it_value would disarm, so use at least 1ns
+        uint64_t deadline_ms = loop->key_base_ms + (uint64_t)(int64_t)min->key;
+        spec.it_value.tv_sec = loop->base.tv_sec + (time_t)(deadline_ms / 1000);
+        spec.it_value.tv_nsec = loop->base.tv_nsec + (long)(deadline_ms % 1000) * 1000000L;
+        if (spec.it_value.tv_nsec >= 1000000000L) {
+            spec.it_value.tv_sec++;
+            spec.it_value.tv_nsec -= 1000000000L;
+        }
+        if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+            spec.it_value.tv_nsec = 1;
+        }
+        loop->armed = true;
+        loop->armed_key = min->key;
+    }
+
+    timerfd_settime(loop->timer_fd, TFD_TIMER_ABSTIME, &spec, NULL);
+    loop->stats.timerfd_arms++;
+}
+
+// Helper function: Shift all keys down so new deadlines stay within int range
+//
+// Subtracting the same amount from every key preserves heap order, so the
+// forest is walked in place (iteratively; tree height is unbounded).
+static void fib_loop_rebase(fib_event_loop_t* loop, uint64_t now_ms) {
+    int shift = (int)(now_ms - loop->key_base_ms);
+    fib_node_t* start = fib_heap_minimum(loop->timers);
+
+    if (start) {
+        fib_node_t* node = start;
+        for (;;) {
+            node->key -= shift;
+            if (node->child) {
+                node = node->child;
+                continue;
+            }
+            while (node->parent && node->right == node->parent->child) {
+                node = node->parent;
+            }
+            node = node->right;
+            if (!node->parent && node == start) {
+                break;
+            }
+        }
+    }
+
+    loop->key_base_ms = now_ms;
+    if (loop->armed) {
+        loop->armed_key -= shift;
+    }
+}
+
+// Helper function: Extract every expired timer, then run the batch
+static void fib_loop_dispatch_timers(fib_event_loop_t* loop) {
+    uint64_t now_ms = fib_loop_elapsed_ms(&loop->base);
+    int64_t now_key = (int64_t)(now_ms - loop->key_base_ms);
+    size_t batch_count = 0;
+
+    fib_node_t* min;
+    while ((min = fib_heap_minimum(loop->timers)) != NULL && min->key <= now_key) {
+        if (batch_count == loop->batch_capacity) {
+            size_t capacity = loop->batch_capacity ? loop->batch_capacity * 2 : 64;
+            fib_timer_t** grown = (fib_timer_t**)realloc(loop->batch, capacity * sizeof(fib_timer_t*));
+            if (!grown) {
+                break; // Remaining timers fire on the next wakeup
+            }
+            loop->batch = grown;
+            loop->batch_capacity = capacity;
+        }
+
+        fib_node_t* node = fib_heap_extract_min(loop->timers);
+        fib_timer_t* timer = (fib_timer_t*)node->data;
+        fib_heap_free_node(loop->timers, node);
+        timer->node = NULL;
+        loop->batch[batch_count++] = timer;
+    }
+
+    for (size_t i = 0; i < batch_count; i++) {
+        fib_timer_t* timer = loop->batch[i];
+        if (!timer->cancelled) {
+            timer->callback(loop, timer->user_ctx);
+            loop->stats.timers_fired++;
+        }
+    }
+    for (size_t i = 0; i < batch_count; i++) {
+        free(loop->batch[i]);
+    }
+}
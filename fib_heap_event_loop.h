@@ -0,0 +1,59 @@
+#ifndef FIB_HEAP_EVENT_LOOP_H
+#define FIB_HEAP_EVENT_LOOP_H
+
+#include "fibonacci_heap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Linux event loop with heap-scheduled timers (epoll + timerfd).
+//
+// Timer deadlines are kept in a Fibonacci heap keyed by milliseconds since
+// the loop was created. A single timerfd is armed to the earliest deadline
+// and is only re-armed when that deadline actually changes. Expired timers
+// are extracted as a batch and their callbacks run afterwards, so timers
+// added or cancelled from a callback take effect on the next batch.
+
+typedef struct fib_event_loop fib_event_loop_t;
+typedef struct fib_timer fib_timer_t;
+
+typedef void (*fib_timer_fn)(fib_event_loop_t* loop, void* user_ctx);
+typedef void (*fib_io_fn)(fib_event_loop_t* loop, int fd, uint32_t events, void* user_ctx);
+
+// Loop counters
+typedef struct {
+    size_t wakeups;             // epoll_wait returns
+    size_t timers_fired;        // Timer callbacks run
+    size_t timerfd_arms;        // timerfd_settime calls
+    size_t pending_timers;      // Timers currently scheduled
+} fib_event_loop_stats_t;
+
+// Loop creation and destruction
+fib_event_loop_t* fib_event_loop_create(void);
+void fib_event_loop_destroy(fib_event_loop_t* loop);
+
+// Timers (one-shot; the handle is invalid once the callback has run)
+fib_timer_t* fib_event_loop_add_timer(fib_event_loop_t* loop, uint32_t timeout_ms,
+                                      fib_timer_fn callback, void* user_ctx);
+fib_heap_error_t fib_event_loop_cancel_timer(fib_event_loop_t* loop, fib_timer_t* timer);
+
+// File descriptors (events are EPOLLIN / EPOLLOUT / ... masks)
+fib_heap_error_t fib_event_loop_add_fd(fib_event_loop_t* loop, int fd, uint32_t events,
+                                       fib_io_fn callback, void* user_ctx);
+fib_heap_error_t fib_event_loop_remove_fd(fib_event_loop_t* loop, int fd);
+
+// Dispatch
+int fib_event_loop_run_once(fib_event_loop_t* loop, int max_wait_ms);
+void fib_event_loop_run(fib_event_loop_t* loop);
+void fib_event_loop_stop(fib_event_loop_t* loop);
+
+// Status inquiry
+uint64_t fib_event_loop_now_ms(fib_event_loop_t* loop);
+fib_event_loop_stats_t fib_event_loop_get_stats(fib_event_loop_t* loop);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIB_HEAP_EVENT_LOOP_H
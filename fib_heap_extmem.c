@@ -0,0 +1,691 @@
+#define _GNU_SOURCE
+#include "fib_heap_extmem.h"
+#include "fib_heap_hash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Constants
+#define FIB_EXTMEM_DEFAULT_HEAD (1024 * 1024)
+#define FIB_EXTMEM_DEFAULT_BLOCK (1024 * 1024)
+#define FIB_EXTMEM_DEFAULT_RUNS 64
+#define FIB_EXTMEM_MIN_RUNS 4
+
+// One queued copy of an item, in the head and in run files
+typedef struct {
+    int32_t key;
+    uint32_t reserved;
+    uint64_t seq;               // Tells a superseded copy from the current one
+    uint64_t id;
+} fib_extmem_record_t;
+
+// A sorted run file and its read cursor
+typedef struct {
+    int fd;
+    uint64_t count;             // Records in the file
+    uint64_t next;              // Records consumed so far
+    fib_extmem_record_t* block; // Buffered mode: records from next - block_pos on
+    size_t block_pos;
+    size_t block_len;
+    fib_extmem_record_t* map;   // Mmap mode: the whole file
+    size_t map_bytes;
+    fib_node_t* node;           // Cursor in a merge heap, keyed by the current record
+} fib_extmem_run_t;
+
+// A queued id, or a popped one whose superseded copies are still queued
+typedef struct {
+    fib_hash_entry_t entry;     // Keyed by id
+    uint64_t latest;            // Sequence of the current copy
+    int32_t key;                // Key of the current copy
+    uint32_t stale;             // Superseded copies not yet dropped
+    bool live;                  // Current copy not yet popped
+} fib_extmem_version_t;
+
+struct fib_extmem {
+    fib_extmem_config_t config;
+    char* dir;
+    size_t block_records;
+
+    fib_heap_t* head;           // Hot items; node data points into slots
+    fib_extmem_record_t* slots;
+    size_t* free_slots;
+    size_t free_count;
+    void** drained;             // Spill scratch, head_capacity entries
+    fib_extmem_record_t* write_block;
+
+    fib_heap_t* cursors;        // Open runs, keyed by their current record
+    fib_extmem_run_t** runs;
+    size_t run_count;
+
+    fib_hash_table_t versions;  // Every queued id
+
+    uint64_t next_seq;
+    uint64_t records;           // Queued copies, superseded ones included
+    uint64_t stale;             // Superseded copies among them
+    bool failed;                // A merge or a spill's reinsert failed halfway; the queue is unusable
+    fib_extmem_stats_t stats;
+};
+
+// Helper function prototypes
+static fib_heap_error_t fib_extmem_insert(fib_extmem_t* queue, int key, uint64_t id, bool update);
+static fib_heap_error_t fib_extmem_head_insert(fib_extmem_t* queue, const fib_extmem_record_t* record);
+static const fib_extmem_record_t* fib_extmem_front(fib_extmem_t* queue, fib_extmem_run_t** run);
+static fib_heap_error_t fib_extmem_drop_front(fib_extmem_t* queue, fib_extmem_run_t* run);
+static bool fib_extmem_is_stale(fib_extmem_t* queue, const fib_extmem_record_t* record, bool consume);
+static fib_heap_error_t fib_extmem_spill(fib_extmem_t* queue);
+static fib_heap_error_t fib_extmem_merge(fib_extmem_t* queue);
+static int fib_extmem_compare_remaining(const void* a, const void* b);
+static fib_extmem_run_t* fib_extmem_run_open(fib_extmem_t* queue);
+static bool fib_extmem_run_append(fib_extmem_t* queue, fib_extmem_run_t* run, size_t* fill,
+                                  const fib_extmem_record_t* record);
+static fib_heap_error_t fib_extmem_run_finish(fib_extmem_t* queue, fib_extmem_run_t* run, size_t fill);
+static void fib_extmem_run_close(fib_extmem_t* queue, fib_extmem_run_t* run);
+static inline const fib_extmem_record_t* fib_extmem_run_current(const fib_extmem_run_t* run);
+static fib_heap_error_t fib_extmem_run_advance(fib_extmem_t* queue, fib_heap_t* heap, fib_extmem_run_t* run);
+static fib_heap_error_t fib_extmem_run_load(fib_extmem_t* queue, fib_extmem_run_t* run);
+static bool fib_extmem_write_all(int fd, const void* buffer, size_t bytes);
+
+// Create an external-memory queue
+fib_extmem_t* fib_extmem_create(const fib_extmem_config_t* config) {
+    fib_extmem_t* queue = (fib_extmem_t*)calloc(1, sizeof(fib_extmem_t));
+    if (!queue) {
+        return NULL;
+    }
+
+    fib_hash_init(&queue->versions, sizeof(fib_extmem_version_t));
+    if (config) {
+        queue->config = *config;
+    }
+    if (queue->config.head_capacity == 0) {
+        queue->config.head_capacity = FIB_EXTMEM_DEFAULT_HEAD;
+    }
+    if (queue->config.head_capacity < 2) {
+        queue->config.head_capacity = 2;
+    }
+    if (queue->config.block_bytes == 0) {
+        queue->config.block_bytes = FIB_EXTMEM_DEFAULT_BLOCK;
+    }
+    if (queue->config.max_runs == 0) {
+        queue->config.max_runs = FIB_EXTMEM_DEFAULT_RUNS;
+    }
+    if (queue->config.max_runs < FIB_EXTMEM_MIN_RUNS) {
+        queue->config.max_runs = FIB_EXTMEM_MIN_RUNS;
+    }
+    const char* dir = queue->config.dir ? queue->config.dir : getenv("TMPDIR");
+    queue->dir = strdup(dir && *dir ? dir : "/tmp");
+    queue->config.dir = queue->dir;
+
+    size_t capacity = queue->config.head_capacity;
+    queue->block_records = queue->config.block_bytes / sizeof(fib_extmem_record_t);
+    if (queue->block_records == 0) {
+        queue->block_records = 1;
+    }
+
+    queue->head = fib_heap_create();
+    queue->cursors = fib_heap_create();
+    queue->slots = (fib_extmem_record_t*)malloc(capacity * sizeof(fib_extmem_record_t));
+    queue->free_slots = (size_t*)malloc(capacity * sizeof(size_t));
+    queue->drained = (void**)malloc(capacity * sizeof(void*));
+    queue->write_block = (fib_extmem_record_t*)malloc(queue->block_records * sizeof(fib_extmem_record_t));
+    queue->runs = (fib_extmem_run_t**)malloc((queue->config.max_runs + 1) * sizeof(fib_extmem_run_t*));
+    if (!queue->dir || !queue->head || !queue->cursors || !queue->slots || !queue->free_slots ||
+        !queue->drained || !queue->write_block || !queue->runs) {
+        fib_extmem_destroy(queue);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < capacity; i++) {
+        queue->free_slots[i] = capacity - 1 - i;
+    }
+    queue->free_count = capacity;
+    return queue;
+}
+
+// Destroy the queue and remove its run files
+void fib_extmem_destroy(fib_extmem_t* queue) {
+    if (!queue) {
+        return;
+    }
+
+    while (queue->run_count) {
+        fib_extmem_run_close(queue, queue->runs[queue->run_count - 1]);
+    }
+
+    // Head nodes point into slots, so destroying the heaps frees everything
+    fib_heap_destroy(queue->head);
+    fib_heap_destroy(queue->cursors);
+    free(queue->slots);
+    free(queue->free_slots);
+    free(queue->drained);
+    free(queue->write_block);
+    free(queue->runs);
+    fib_hash_free(&queue->versions);
+    free(queue->dir);
+    free(queue);
+}
+
+// Add an item
+fib_heap_error_t fib_extmem_push(fib_extmem_t* queue, int key, uint64_t id) {
+    if (!queue) {
+        return FIB_HEAP_ERROR_NULL_POINTER;
+    }
+    return fib_extmem_insert(queue, key, id, false);
+}
+
+// Reinsert a queued id under a smaller key; the old copy is skipped when it surfaces
+fib_heap_error_t fib_extmem_decrease_key(fib_extmem_t* queue, uint64_t id, int new_key) {
+    if (!queue) {
+        return FIB_HEAP_ERROR_NULL_POINTER;
+    }
+    return fib_extmem_insert(queue, new_key, id, true);
+}
+
+// Remove the item with the smallest key
+fib_heap_error_t fib_extmem_pop(fib_extmem_t* queue, int* key, uint64_t* id) {
+    if (!queue) {
+        return FIB_HEAP_ERROR_NULL_POINTER;
+    }
+    if (queue->failed) {
+        return FIB_HEAP_ERROR_INVALID_STATE;
+    }
+
+    for (;;) {
+        fib_extmem_run_t* run;
+        const fib_extmem_record_t* front = fib_extmem_front(queue, &run);
+        if (!front) {
+            return FIB_HEAP_ERROR_EMPTY_HEAP;
+        }
+
+        fib_extmem_record_t record = *front;
+        fib_heap_error_t result = fib_extmem_drop_front(queue, run);
+        if (result != FIB_HEAP_SUCCESS) {
+            return result;
+        }
+        if (fib_extmem_is_stale(queue, &record, true)) {
+            queue->stats.stale_dropped++;
+            continue;
+        }
+
+        if (key) *key = record.key;
+        if (id) *id = record.id;
+        return FIB_HEAP_SUCCESS;
+    }
+}
+
+// Look at the item with the smallest key, dropping superseded copies on the way
+fib_heap_error_t fib_extmem_peek(fib_extmem_t* queue, int* key, uint64_t* id) {
+    if (!queue) {
+        return FIB_HEAP_ERROR_NULL_POINTER;
+    }
+    if (queue->failed) {
+        return FIB_HEAP_ERROR_INVALID_STATE;
+    }
+
+    for (;;) {
+        fib_extmem_run_t* run;
+        const fib_extmem_record_t* front = fib_extmem_front(queue, &run);
+        if (!front) {
+            return FIB_HEAP_ERROR_EMPTY_HEAP;
+        }
+
+        if (!fib_extmem_is_stale(queue, front, false)) {
+            if (key) *key = front->key;
+            if (id) *id = front->id;
+            return FIB_HEAP_SUCCESS;
+        }
+
+        queue->stats.stale_dropped++;
+        fib_heap_error_t result = fib_extmem_drop_front(queue, run);
+        if (result != FIB_HEAP_SUCCESS) {
+            return result;
+        }
+    }
+}
+
+// Get number of queued items
+uint64_t fib_extmem_size(fib_extmem_t* queue) {
+    return queue ? queue->records - queue->stale : 0;
+}
+
+// Get I/O counters
+fib_extmem_stats_t fib_extmem_get_stats(fib_extmem_t* queue) {
+    fib_extmem_stats_t stats = {0};
+    if (!queue) {
+        return stats;
+    }
+
+    stats = queue->stats;
+    stats.runs = queue->run_count;
+    stats.head_size = fib_heap_size(queue->head);
+    return stats;
+}
+
+// Helper function: Insert a copy; with update, the current copy of id becomes stale
+//
+// A push needs an id that is not queued, an update one that is, with a key
+// no greater than new key.
+static fib_heap_error_t fib_extmem_insert(fib_extmem_t* queue, int key, uint64_t id, bool update) {
+    if (queue->failed) {
+        return FIB_HEAP_ERROR_INVALID_STATE;
+    }
+
+    fib_extmem_version_t* version = (fib_extmem_version_t*)fib_hash_find(&queue->versions, id);
+    bool queued = version && version->live;
+    if (queued != update) {
+        return FIB_HEAP_ERROR_INVALID_HANDLE;
+    }
+    if (update && key >= version->key) {
+        return key == version->key ? FIB_HEAP_SUCCESS : FIB_HEAP_ERROR_INVALID_KEY;
+    }
+
+    if (fib_heap_size(queue->head) >= queue->config.head_capacity) {
+        fib_heap_error_t result = fib_extmem_spill(queue);
+        if (result != FIB_HEAP_SUCCESS) {
+            return result;
+        }
+    }
+
+    // A spill may erase entries and growing the table moves them, so look
+    // up again once room is reserved
+    if (!fib_hash_reserve(&queue->versions, 1)) {
+        return FIB_HEAP_ERROR_OUT_OF_MEMORY;
+    }
+    version = (fib_extmem_version_t*)fib_hash_find(&queue->versions, id);
+
+    fib_extmem_record_t record = {key, 0, queue->next_seq, id};
+    fib_heap_error_t result = fib_extmem_head_insert(queue, &record);
+    if (result != FIB_HEAP_SUCCESS) {
+        return result;
+    }
+    queue->next_seq++;
+    queue->records++;
+
+    if (!version) {
+        version = (fib_extmem_version_t*)fib_hash_add(&queue->versions, id);
+    }
+    if (version->live) {
+        version->stale++;
+        queue->stale++;
+    }
+    version->latest = record.seq;
+    version->key = key;
+    version->live = true;
+    return FIB_HEAP_SUCCESS;
+}
+
+// Helper function: Put a record into a free head slot
+static fib_heap_error_t fib_extmem_head_insert(fib_extmem_t* queue, const fib_extmem_record_t* record) {
+    fib_extmem_record_t* slot = &queue->slots[queue->free_slots[queue->free_count - 1]];
+    *slot = *record;
+    if (!fib_heap_insert(queue->head, record->key, slot)) {
+        return FIB_HEAP_ERROR_OUT_OF_MEMORY;
+    }
+    queue->free_count--;
+    return FIB_HEAP_SUCCESS;
+}
+
+// Helper function: Smallest record of the head and the runs, and the run holding it
+static const fib_extmem_record_t* fib_extmem_front(fib_extmem_t* queue, fib_extmem_run_t** run) {
+    fib_node_t* head_min = fib_heap_minimum(queue->head);
+    fib_node_t* cursor = fib_heap_minimum(queue->cursors);
+
+    *run = NULL;
+    if (cursor && (!head_min || cursor->key < head_min->key)) {
+        *run = (fib_extmem_run_t*)cursor->data;
+        return fib_extmem_run_current(*run);
+    }
+    return head_min ? (const fib_extmem_record_t*)head_min->data : NULL;
+}
+
+// Helper function: Remove the record fib_extmem_front returned
+static fib_heap_error_t fib_extmem_drop_front(fib_extmem_t* queue, fib_extmem_run_t* run) {
+    queue->records--;
+    if (run) {
+        return fib_extmem_run_advance(queue, queue->cursors, run);
+    }
+
+    fib_node_t* node = fib_heap_extract_min(queue->head);
+    queue->free_slots[queue->free_count++] = (size_t)((fib_extmem_record_t*)node->data - queue->slots);
+    fib_heap_free_node(queue->head, node);
+    return FIB_HEAP_SUCCESS;
+}
+
+// Helper function: Whether a record was superseded by a later decrease-key
+//
+// A stale copy is counted as dropped. With consume, the current copy is
+// marked popped, and the entry goes once no copy of the id is left.
+static bool fib_extmem_is_stale(fib_extmem_t* queue, const fib_extmem_record_t* record, bool consume) {
+    fib_extmem_version_t* version = (fib_extmem_version_t*)fib_hash_find(&queue->versions, record->id);
+    if (!version) {
+        return false;
+    }
+
+    bool stale = !version->live || version->latest != record->seq;
+    if (stale) {
+        version->stale--;
+        queue->stale--;
+    } else if (consume) {
+        version->live = false;
+    }
+    if (!version->live && version->stale == 0) {
+        fib_hash_erase(&queue->versions, &version->entry);
+    }
+    return stale;
+}
+
+// Helper function: Keep the smaller half of a full head and write the rest as a run
+//
+// The drain leaves the head empty and its records in sorted order; if the
+// run cannot be written, every record goes back and the queue is unchanged.
+// Reinserting allocates nodes again, and if that fails the records not yet
+// back are lost, so the queue is marked failed.
+static fib_heap_error_t fib_extmem_spill(fib_extmem_t* queue) {
+    size_t n = fib_heap_size(queue->head);
+    size_t keep = n / 2;
+
+    if (queue->run_count >= queue->config.max_runs) {
+        fib_heap_error_t result = fib_extmem_merge(queue);
+        if (result != FIB_HEAP_SUCCESS) {
+            return result;
+        }
+    }
+
+    fib_heap_error_t result = fib_heap_drain_sorted(queue->head, NULL, queue->drained);
+    if (result != FIB_HEAP_SUCCESS) {
+        return result;
+    }
+
+    fib_extmem_run_t* run = fib_extmem_run_open(queue);
+    size_t fill = 0;
+    bool written = run != NULL;
+    for (size_t i = keep; written && i < n; i++) {
+        written = fib_extmem_run_append(queue, run, &fill, (const fib_extmem_record_t*)queue->drained[i]);
+    }
+    if (written) {
+        result = fib_extmem_run_finish(queue, run, fill);
+    } else {
+        result = FIB_HEAP_ERROR_INVALID_STATE;
+        if (run) {
+            fib_extmem_run_close(queue, run);
+        }
+    }
+
+    if (result == FIB_HEAP_SUCCESS) {
+        queue->stats.records_spilled += n - keep;
+    }
+
+    size_t back = result == FIB_HEAP_SUCCESS ? keep : n;
+    size_t inserted = 0;
+    while (inserted < back) {
+        fib_extmem_record_t* slot = (fib_extmem_record_t*)queue->drained[inserted];
+        if (!fib_heap_insert(queue->head, slot->key, slot)) {
+            queue->records -= back - inserted;
+            queue->failed = true;
+            result = FIB_HEAP_ERROR_OUT_OF_MEMORY;
+            break;
+        }
+        inserted++;
+    }
+    for (size_t i = inserted; i < n; i++) {
+        queue->free_slots[queue->free_count++] =
+            (size_t)((fib_extmem_record_t*)queue->drained[i] - queue->slots);
+    }
+    return result;
+}
+
+// Helper function: Merge the half of the runs with the fewest remaining records
+//
+// Always merging the smaller runs lets run sizes grow geometrically, so each
+// record is rewritten O(log(n / head_capacity)) times. Superseded copies are
+// dropped instead of being written again. A failure here leaves the source
+// runs partly consumed, so the queue is marked failed.
+static fib_heap_error_t fib_extmem_merge(fib_extmem_t* queue) {
+    size_t k = queue->run_count / 2;
+    fib_heap_t* merge = fib_heap_create();
+    fib_extmem_run_t* target = fib_extmem_run_open(queue);
+    if (!merge || !target) {
+        fib_heap_destroy(merge);
+        if (target) {
+            fib_extmem_run_close(queue, target);
+        }
+        return FIB_HEAP_ERROR_OUT_OF_MEMORY;
+    }
+
+    // The k smallest runs move to the front of the array and into the merge heap
+    qsort(queue->runs, queue->run_count, sizeof(fib_extmem_run_t*), fib_extmem_compare_remaining);
+    for (size_t i = 0; i < k; i++) {
+        fib_extmem_run_t* run = queue->runs[i];
+        fib_heap_delete_node(queue->cursors, run->node);
+        run->node = fib_heap_insert(merge, fib_extmem_run_current(run)->key, run);
+    }
+
+    fib_heap_error_t result = FIB_HEAP_SUCCESS;
+    size_t fill = 0;
+    fib_node_t* cursor;
+    while (result == FIB_HEAP_SUCCESS && (cursor = fib_heap_minimum(merge)) != NULL) {
+        fib_extmem_run_t* run = (fib_extmem_run_t*)cursor->data;
+        const fib_extmem_record_t* record = fib_extmem_run_current(run);
+        if (fib_extmem_is_stale(queue, record, false)) {
+            queue->records--;
+            queue->stats.stale_dropped++;
+        } else if (!fib_extmem_run_append(queue, target, &fill, record)) {
+            result = FIB_HEAP_ERROR_INVALID_STATE;
+            break;
+        }
+        result = fib_extmem_run_advance(queue, merge, run);
+    }
+
+    if (result == FIB_HEAP_SUCCESS) {
+        result = fib_extmem_run_finish(queue, target, fill);
+    } else {
+        fib_extmem_run_close(queue, target);
+    }
+
+    // Sources that were not exhausted go back to the main cursor heap
+    while ((cursor = fib_heap_extract_min(merge)) != NULL) {
+        fib_extmem_run_t* run = (fib_extmem_run_t*)cursor->data;
+        fib_heap_free_node(merge, cursor);
+        run->node = fib_heap_insert(queue->cursors, fib_extmem_run_current(run)->key, run);
+    }
+    fib_heap_destroy(merge);
+
+    if (result != FIB_HEAP_SUCCESS) {
+        queue->failed = true;
+        return result;
+    }
+    queue->stats.merges++;
+    return FIB_HEAP_SUCCESS;
+}
+
+// Helper function: qsort order for runs, fewest remaining records first
+static int fib_extmem_compare_remaining(const void* a, const void* b) {
+    const fib_extmem_run_t* x = *(const fib_extmem_run_t* const*)a;
+    const fib_extmem_run_t* y = *(const fib_extmem_run_t* const*)b;
+    uint64_t rx = x->count - x->next;
+    uint64_t ry = y->count - y->next;
+    return rx < ry ? -1 : (rx > ry);
+}
+
+// Helper function: Create an empty, already unlinked run file
+static fib_extmem_run_t* fib_extmem_run_open(fib_extmem_t* queue) {
+    fib_extmem_run_t* run = (fib_extmem_run_t*)calloc(1, sizeof(fib_extmem_run_t));
+    size_t path_len = strlen(queue->dir) + sizeof("/fibheap-run-XXXXXX");
+    char* path = (char*)malloc(path_len);
+    if (!run || !path) {
+        free(run);
+        free(path);
+        return NULL;
+    }
+
+    snprintf(path, path_len, "%s/fibheap-run-XXXXXX", queue->dir);
+    run->fd = mkstemp(path);
+    if (run->fd >= 0) {
+        unlink(path);
+    }
+    free(path);
+    if (run->fd < 0) {
+        free(run);
+        return NULL;
+    }
+    return run;
+}
+
+// Helper function: Append one record through the shared write block
+static bool fib_extmem_run_append(fib_extmem_t* queue, fib_extmem_run_t* run, size_t* fill,
+                                  const fib_extmem_record_t* record) {
+    queue->write_block[(*fill)++] = *record;
+    run->count++;
+    if (*fill < queue->block_records) {
+        return true;
+    }
+
+    size_t bytes = *fill * sizeof(fib_extmem_record_t);
+    *fill = 0;
+    queue->stats.bytes_written += bytes;
+    return fib_extmem_write_all(run->fd, queue->write_block, bytes);
+}
+
+// Helper function: Flush a written run and open it for reading
+//
+// An empty run (a merge that only met stale copies) is simply closed.
+static fib_heap_error_t fib_extmem_run_finish(fib_extmem_t* queue, fib_extmem_run_t* run, size_t fill) {
+    size_t bytes = fill * sizeof(fib_extmem_record_t);
+    queue->stats.bytes_written += bytes;
+    if (!fib_extmem_write_all(run->fd, queue->write_block, bytes)) {
+        fib_extmem_run_close(queue, run);
+        return FIB_HEAP_ERROR_INVALID_STATE;
+    }
+    if (run->count == 0) {
+        fib_extmem_run_close(queue, run);
+        return FIB_HEAP_SUCCESS;
+    }
+
+    if (queue->config.io == FIB_EXTMEM_IO_MMAP) {
+        run->map_bytes = run->count * sizeof(fib_extmem_record_t);
+        void* map = mmap(NULL, run->map_bytes, PROT_READ, MAP_SHARED, run->fd, 0);
+        if (map == MAP_FAILED) {
+            fib_extmem_run_close(queue, run);
+            return FIB_HEAP_ERROR_INVALID_STATE;
+        }
+        madvise(map, run->map_bytes, MADV_SEQUENTIAL);
+        run->map = (fib_extmem_record_t*)map;
+    } else {
+        run->block = (fib_extmem_record_t*)malloc(queue->block_records * sizeof(fib_extmem_record_t));
+        fib_heap_error_t result = run->block ? fib_extmem_run_load(queue, run) : FIB_HEAP_ERROR_OUT_OF_MEMORY;
+        if (result != FIB_HEAP_SUCCESS) {
+            fib_extmem_run_close(queue, run);
+            return result;
+        }
+    }
+
+    run->node = fib_heap_insert(queue->cursors, fib_extmem_run_current(run)->key, run);
+    if (!run->node) {
+        fib_extmem_run_close(queue, run);
+        return FIB_HEAP_ERROR_OUT_OF_MEMORY;
+    }
+    queue->runs[queue->run_count++] = run;
+    queue->stats.runs_written++;
+    return FIB_HEAP_SUCCESS;
+}
+
+// Helper function: Close a run's file and forget it
+static void fib_extmem_run_close(fib_extmem_t* queue, fib_extmem_run_t* run) {
+    for (size_t i = 0; i < queue->run_count; i++) {
+        if (queue->runs[i] == run) {
+            queue->runs[i] = queue->runs[--queue->run_count];
+            break;
+        }
+    }
+    if (run->map) {
+        munmap(run->map, run->map_bytes);
+    }
+    free(run->block);
+    close(run->fd);
+    free(run);
+}
+
+// Helper function: Record under a run's cursor
+static inline const fib_extmem_record_t* fib_extmem_run_current(const fib_extmem_run_t* run) {
+    return run->map ? &run->map[run->next] : &run->block[run->block_pos];
+}
+
+// Helper function: Step past a run's current record, the minimum of heap
+//
+// The cursor is re-keyed in heap, or removed and the run closed once the
+// run is exhausted.
+static fib_heap_error_t fib_extmem_run_advance(fib_extmem_t* queue, fib_heap_t* heap, fib_extmem_run_t* run) {
+    if (run->map) {
+        queue->stats.bytes_read += sizeof(fib_extmem_record_t);
+    }
+
+    run->next++;
+    if (run->next == run->count) {
+        fib_heap_free_node(heap, fib_heap_extract_min(heap));
+        fib_extmem_run_close(queue, run);
+        return FIB_HEAP_SUCCESS;
+    }
+
+    if (run->map) {
+        // Consumed pages are only page cache; unmapping them keeps RSS flat
+        if (run->next % queue->block_records == 0) {
+            size_t page = (size_t)sysconf(_SC_PAGESIZE);
+            size_t done = (run->next * sizeof(fib_extmem_record_t)) & ~(page - 1);
+            madvise(run->map, done, MADV_DONTNEED);
+        }
+    } else if (++run->block_pos == run->block_len) {
+        fib_heap_error_t result = fib_extmem_run_load(queue, run);
+        if (result != FIB_HEAP_SUCCESS) {
+            return result;
+        }
+    }
+
+    int key = fib_extmem_run_current(run)->key;
+    if (key != run->node->key) {
+        fib_heap_free_node(heap, fib_heap_extract_min(heap));
+        run->node = fib_heap_insert(heap, key, run);
+        if (!run->node) {
+            queue->failed = true;
+            return FIB_HEAP_ERROR_OUT_OF_MEMORY;
+        }
+    }
+    return FIB_HEAP_SUCCESS;
+}
+
+// Helper function: Read the block starting at a run's cursor
+static fib_heap_error_t fib_extmem_run_load(fib_extmem_t* queue, fib_extmem_run_t* run) {
+    uint64_t remaining = run->count - run->next;
+    size_t records = remaining < queue->block_records ? (size_t)remaining : queue->block_records;
+    size_t bytes = records * sizeof(fib_extmem_record_t);
+    off_t offset = (off_t)(run->next * sizeof(fib_extmem_record_t));
+
+    size_t done = 0;
+    while (done < bytes) {
+        ssize_t got = pread(run->fd, (char*)run->block + done, bytes - done, offset + (off_t)done);
+        if (got <= 0) {
+            queue->failed = true;
+            return FIB_HEAP_ERROR_HEAP_CORRUPTION;
+        }
+        done += (size_t)got;
+    }
+
+    queue->stats.bytes_read += bytes;
+    run->block_pos = 0;
+    run->block_len = records;
+    return FIB_HEAP_SUCCESS;
+}
+
+// Helper function: write(2) until everything is written
+static bool fib_extmem_write_all(int fd, const void* buffer, size_t bytes) {
+    const char* p = (const char*)buffer;
+    while (bytes) {
+        ssize_t written = write(fd, p, bytes);
+        if (written <= 0) {
+            return false;
+        }
+        p += written;
+        bytes -= (size_t)written;
+    }
+    return true;
+}
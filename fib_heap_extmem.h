@@ -0,0 +1,90 @@
+#ifndef FIB_HEAP_EXTMEM_H
+#define FIB_HEAP_EXTMEM_H
+
+#include "fibonacci_heap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// External-memory priority queue for more items than fit in RAM.
+//
+// Items are (key, id) pairs, where id is a caller-chosen 64-bit value such
+// as an event or vertex number. The smallest items live in an in-memory
+// Fibonacci heap (the head). When the head fills up it is drained in sorted
+// order, its smaller half is put back and the larger half is written to a
+// local file as a sorted run. Runs are never sorted again: they are read
+// block by block through a small heap of run cursors, so a run is only
+// touched as the head drains down to its keys. Once max_runs runs exist,
+// the smaller half of them is merged into one, which keeps the number of
+// read buffers bounded and rewrites each item only a logarithmic number of
+// times.
+//
+// Decrease-key reinserts the id with the new key and a fresh sequence
+// number. A table of queued ids (in memory, 32 bytes per queued id, and per
+// popped id whose superseded copies are still in a run) holds each id's
+// current sequence and key: pops skip the copies that were superseded,
+// merges drop them from the files, and pushes of an id already queued or
+// updates of an id that is not are rejected.
+// Run files are created in the configured directory and unlinked at once,
+// so they disappear with the queue or the process. A queue is not
+// thread-safe.
+
+// How runs are read back
+typedef enum {
+    FIB_EXTMEM_IO_BUFFERED = 0, // pread into a block buffer per run (default)
+    FIB_EXTMEM_IO_MMAP          // Map each run and read it in place
+} fib_extmem_io_t;
+
+typedef struct {
+    size_t head_capacity;       // Items held in memory (0 = 1M)
+    size_t block_bytes;         // Read/write buffer per run (0 = 1 MiB)
+    size_t max_runs;            // Runs kept before the smaller half is merged (0 = 64, min 4)
+    const char* dir;            // Directory for run files (NULL = $TMPDIR or /tmp)
+    fib_extmem_io_t io;
+} fib_extmem_config_t;
+
+// I/O and merge counters
+typedef struct {
+    uint64_t bytes_written;     // Written to run files
+    uint64_t bytes_read;        // Read back (in mmap mode: bytes consumed from maps)
+    uint64_t runs_written;      // Runs created by spills and merges
+    uint64_t merges;            // Merges of existing runs
+    uint64_t records_spilled;   // Items written by spills (merges not counted)
+    uint64_t stale_dropped;     // Superseded copies skipped by pops or merges
+    size_t runs;                // Runs currently open
+    size_t head_size;           // Items currently in the head
+} fib_extmem_stats_t;
+
+typedef struct fib_extmem fib_extmem_t;
+
+// Queue creation and destruction (config may be NULL for the defaults)
+fib_extmem_t* fib_extmem_create(const fib_extmem_config_t* config);
+void fib_extmem_destroy(fib_extmem_t* queue);
+
+// Queue operations. Push returns FIB_HEAP_ERROR_INVALID_HANDLE for an id
+// that is already queued. Pop and peek return FIB_HEAP_ERROR_EMPTY_HEAP when
+// the queue is empty; failed file I/O is reported as
+// FIB_HEAP_ERROR_INVALID_STATE (a failed spill leaves the queue as it was)
+// and a short read of a run as FIB_HEAP_ERROR_HEAP_CORRUPTION. If memory
+// runs out while a spill puts records back into the head, push and
+// decrease-key return FIB_HEAP_ERROR_OUT_OF_MEMORY and the queue refuses
+// further use.
+fib_heap_error_t fib_extmem_push(fib_extmem_t* queue, int key, uint64_t id);
+fib_heap_error_t fib_extmem_pop(fib_extmem_t* queue, int* key, uint64_t* id);
+fib_heap_error_t fib_extmem_peek(fib_extmem_t* queue, int* key, uint64_t* id);
+
+// Lower the key of a queued id. Returns FIB_HEAP_ERROR_INVALID_HANDLE if the
+// id is not queued (never pushed, or already popped) and
+// FIB_HEAP_ERROR_INVALID_KEY if new_key is greater than its current key.
+fib_heap_error_t fib_extmem_decrease_key(fib_extmem_t* queue, uint64_t id, int new_key);
+
+// Status inquiry
+uint64_t fib_extmem_size(fib_extmem_t* queue);
+fib_extmem_stats_t fib_extmem_get_stats(fib_extmem_t* queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIB_HEAP_EXTMEM_H
@@ -0,0 +1,110 @@
+#include "fib_heap_hash.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Constants
+#define FIB_HASH_MIN_CAPACITY 64
+
+// Helper function prototypes
+static inline size_t fib_hash_home(uint64_t key);
+
+// Start an empty table; nothing is allocated until the first reserve
+void fib_hash_init(fib_hash_table_t* table, size_t entry_size) {
+    table->entries = NULL;
+    table->entry_size = entry_size;
+    table->capacity = 0;
+    table->count = 0;
+}
+
+// Release the table's storage (entries own nothing)
+void fib_hash_free(fib_hash_table_t* table) {
+    free(table->entries);
+    table->entries = NULL;
+    table->capacity = 0;
+    table->count = 0;
+}
+
+// Look up a key
+fib_hash_entry_t* fib_hash_find(const fib_hash_table_t* table, uint64_t key) {
+    if (!table->count) {
+        return NULL;
+    }
+
+    size_t mask = table->capacity - 1;
+    for (size_t i = fib_hash_home(key) & mask;; i = (i + 1) & mask) {
+        fib_hash_entry_t* entry = fib_hash_slot(table, i);
+        if (!entry->used) {
+            return NULL;
+        }
+        if (entry->key == key) {
+            return entry;
+        }
+    }
+}
+
+// Make room for count more entries, keeping the load at most 1/2
+bool fib_hash_reserve(fib_hash_table_t* table, size_t count) {
+    if ((table->count + count) * 2 <= table->capacity) {
+        return true;
+    }
+
+    size_t capacity = table->capacity ? table->capacity : FIB_HASH_MIN_CAPACITY;
+    while ((table->count + count) * 2 > capacity) {
+        capacity *= 2;
+    }
+    unsigned char* entries = (unsigned char*)calloc(capacity, table->entry_size);
+    if (!entries) {
+        return false;
+    }
+
+    fib_hash_table_t old = *table;
+    table->entries = entries;
+    table->capacity = capacity;
+    table->count = 0;
+    for (size_t i = 0; i < old.capacity; i++) {
+        fib_hash_entry_t* entry = fib_hash_slot(&old, i);
+        if (entry->used) {
+            memcpy(fib_hash_add(table, entry->key), entry, table->entry_size);
+        }
+    }
+    free(old.entries);
+    return true;
+}
+
+// Insert a key known to be absent
+fib_hash_entry_t* fib_hash_add(fib_hash_table_t* table, uint64_t key) {
+    size_t mask = table->capacity - 1;
+    size_t i = fib_hash_home(key) & mask;
+    while (fib_hash_slot(table, i)->used) {
+        i = (i + 1) & mask;
+    }
+
+    fib_hash_entry_t* entry = fib_hash_slot(table, i);
+    memset(entry, 0, table->entry_size);
+    entry->key = key;
+    entry->used = true;
+    table->count++;
+    return entry;
+}
+
+// Remove an entry, shifting later probes back into the gap
+void fib_hash_erase(fib_hash_table_t* table, fib_hash_entry_t* entry) {
+    size_t mask = table->capacity - 1;
+    size_t hole = (size_t)((unsigned char*)entry - table->entries) / table->entry_size;
+    for (size_t j = (hole + 1) & mask; fib_hash_slot(table, j)->used; j = (j + 1) & mask) {
+        // An entry may fill the hole only if its home slot is not in (hole, j]
+        size_t home = fib_hash_home(fib_hash_slot(table, j)->key) & mask;
+        bool between = hole <= j ? (hole < home && home <= j) : (hole < home || home <= j);
+        if (!between) {
+            memcpy(fib_hash_slot(table, hole), fib_hash_slot(table, j), table->entry_size);
+            hole = j;
+        }
+    }
+    fib_hash_slot(table, hole)->used = false;
+    table->count--;
+}
+
+// Helper function: Home slot of a key before masking (Fibonacci hashing)
+static inline size_t fib_hash_home(uint64_t key) {
+    return (size_t)((key * 0x9E3779B97F4A7C15ULL) >> 20);
+}
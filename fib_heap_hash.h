@@ -0,0 +1,52 @@
+#ifndef FIB_HEAP_HASH_H
+#define FIB_HEAP_HASH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Internal open-addressing table keyed by uint64_t, shared by the
+// front-ends that map ids, keys or node addresses to their own records.
+// Not part of the public API.
+//
+// Linear probing over a power-of-two capacity with Fibonacci hashing; the
+// load stays at most 1/2 and erase shifts later probes back instead of
+// leaving tombstones. A module declares its entry type with fib_hash_entry_t
+// as the first member and passes its size to fib_hash_init. Entry pointers
+// stay valid until the next fib_hash_reserve that grows the table or the
+// next fib_hash_erase.
+
+// Header of every entry
+typedef struct {
+    uint64_t key;
+    bool used;
+} fib_hash_entry_t;
+
+typedef struct {
+    unsigned char* entries;
+    size_t entry_size;
+    size_t capacity;            // Power of two, 0 until the first reserve
+    size_t count;
+} fib_hash_table_t;
+
+void fib_hash_init(fib_hash_table_t* table, size_t entry_size);
+void fib_hash_free(fib_hash_table_t* table);
+
+// Entry for a key, or NULL
+fib_hash_entry_t* fib_hash_find(const fib_hash_table_t* table, uint64_t key);
+
+// Make room for count more entries; false if the larger table cannot be allocated
+bool fib_hash_reserve(fib_hash_table_t* table, size_t count);
+
+// Insert a key known to be absent (room must be reserved); the rest of the entry is zeroed
+fib_hash_entry_t* fib_hash_add(fib_hash_table_t* table, uint64_t key);
+
+// Remove an entry returned by find or add
+void fib_hash_erase(fib_hash_table_t* table, fib_hash_entry_t* entry);
+
+// Slot i (i < capacity), for walking every entry; check used
+static inline fib_hash_entry_t* fib_hash_slot(const fib_hash_table_t* table, size_t i) {
+    return (fib_hash_entry_t*)(table->entries + i * table->entry_size);
+}
+
+#endif // FIB_HEAP_HASH_H
@@ -0,0 +1,443 @@
+#define _GNU_SOURCE
+#include "fib_heap_mpsc.h"
+#include "fib_heap_hash.h"
+#include <sched.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Constants
+#define FIB_MPSC_CACHE_LINE 64
+#define FIB_MPSC_DEFAULT_CAPACITY 65536
+#define FIB_MPSC_BATCH 256              // Inserts spliced per fib_heap_insert_batch call
+
+// Message kinds
+enum {
+    FIB_MPSC_OP_INSERT = 0,
+    FIB_MPSC_OP_DECREASE_KEY
+};
+
+// Ring slot. seq == position: free for the producer claiming that position;
+// seq == position + 1: written, waiting for the consumer.
+typedef struct {
+    uint64_t seq;               // (atomic)
+    int op;
+    int key;
+    void* data;                 // Insert: item data
+    uint64_t generation;        // Decrease-key: the handle's generation
+    fib_mpsc_ticket_t* ticket;
+} fib_mpsc_slot_t;
+
+// Handle table entry: where a ticketed item's node is now
+typedef struct {
+    fib_hash_entry_t entry;     // Keyed by the generation it was handed out under
+    fib_node_t* node;
+} fib_mpsc_handle_entry_t;
+
+// Reverse entry: the generation of a ticketed node
+typedef struct {
+    fib_hash_entry_t entry;     // Keyed by node address
+    uint64_t generation;
+} fib_mpsc_node_entry_t;
+
+// fib_mpsc_compact's context for the relocate callback
+typedef struct {
+    fib_mpsc_t* queue;
+    fib_heap_relocate_fn relocate;
+    void* user_ctx;
+} fib_mpsc_compact_ctx_t;
+
+struct fib_mpsc {
+    fib_heap_t* heap;
+    fib_mpsc_slot_t* slots;
+    uint64_t mask;              // Capacity - 1
+
+    // Producer side, on its own cache line
+    uint64_t tail __attribute__((aligned(FIB_MPSC_CACHE_LINE)));   // Next position to claim (atomic)
+    uint64_t full;              // Calls refused on a full ring (atomic)
+
+    // Consumer side
+    uint64_t head __attribute__((aligned(FIB_MPSC_CACHE_LINE)));   // Next position to read
+    fib_mpsc_stats_t stats;
+    int batch_keys[FIB_MPSC_BATCH];
+    void* batch_data[FIB_MPSC_BATCH];
+    fib_mpsc_ticket_t* batch_tickets[FIB_MPSC_BATCH];
+    fib_node_t* batch_nodes[FIB_MPSC_BATCH];
+
+    fib_hash_table_t handles;   // Ticketed items still in the heap, by generation
+    fib_hash_table_t handle_nodes; // The same items by node address
+    uint64_t next_generation;   // Never reused, so a recycled node address gets a new one
+};
+
+// Helper function prototypes
+static fib_heap_error_t fib_mpsc_push(fib_mpsc_t* queue, int op, int key, void* data,
+                                      uint64_t generation, fib_mpsc_ticket_t* ticket);
+static void fib_mpsc_flush(fib_mpsc_t* queue, size_t count);
+static void fib_mpsc_apply_decrease(fib_mpsc_t* queue, const fib_mpsc_slot_t* slot);
+static void fib_mpsc_resolve(fib_mpsc_ticket_t* ticket, fib_node_t* node, uint64_t generation);
+static inline fib_mpsc_node_entry_t* fib_mpsc_node_find(fib_mpsc_t* queue, const fib_node_t* node);
+static void fib_mpsc_handle_add(fib_mpsc_t* queue, fib_node_t* node, uint64_t generation);
+static void fib_mpsc_handle_retire(fib_mpsc_t* queue, const fib_node_t* node);
+static void fib_mpsc_relocate(fib_node_t* old_node, fib_node_t* new_node, void* user_ctx);
+
+// Create a front-end feeding heap
+fib_mpsc_t* fib_mpsc_create(fib_heap_t* heap, size_t capacity) {
+    if (!heap) {
+        return NULL;
+    }
+    if (capacity == 0) {
+        capacity = FIB_MPSC_DEFAULT_CAPACITY;
+    }
+    size_t rounded = 2;
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+
+    void* memory = NULL;
+    if (posix_memalign(&memory, FIB_MPSC_CACHE_LINE, sizeof(fib_mpsc_t)) != 0) {
+        return NULL;
+    }
+    fib_mpsc_t* queue = (fib_mpsc_t*)memory;
+    memset(queue, 0, sizeof(fib_mpsc_t));
+
+    queue->slots = (fib_mpsc_slot_t*)malloc(rounded * sizeof(fib_mpsc_slot_t));
+    if (!queue->slots) {
+        free(queue);
+        return NULL;
+    }
+    for (size_t i = 0; i < rounded; i++) {
+        queue->slots[i].seq = i;
+    }
+
+    queue->heap = heap;
+    queue->mask = rounded - 1;
+    queue->next_generation = 1;
+    fib_hash_init(&queue->handles, sizeof(fib_mpsc_handle_entry_t));
+    fib_hash_init(&queue->handle_nodes, sizeof(fib_mpsc_node_entry_t));
+    return queue;
+}
+
+// Destroy the front-end (the heap is not destroyed)
+void fib_mpsc_destroy(fib_mpsc_t* queue) {
+    if (!queue) {
+        return;
+    }
+
+    fib_hash_free(&queue->handles);
+    fib_hash_free(&queue->handle_nodes);
+    free(queue->slots);
+    free(queue);
+}
+
+// Queue an insert
+fib_heap_error_t fib_mpsc_insert(fib_mpsc_t* queue, int key, void* data, fib_mpsc_ticket_t* ticket) {
+    if (!queue) {
+        return FIB_HEAP_ERROR_NULL_POINTER;
+    }
+
+    // Published to the consumer by the slot's release store
+    if (ticket) {
+        ticket->handle.node = NULL;
+        ticket->handle.generation = 0;
+        ticket->state = FIB_MPSC_PENDING;
+    }
+    return fib_mpsc_push(queue, FIB_MPSC_OP_INSERT, key, data, 0, ticket);
+}
+
+// Queue a decrease-key of an item whose ticket has resolved
+//
+// The consumer checks the handle when it applies the message and drops it if
+// the item has left the heap in the meantime.
+fib_heap_error_t fib_mpsc_decrease_key(fib_mpsc_t* queue, fib_mpsc_handle_t handle, int new_key) {
+    if (!queue) {
+        return FIB_HEAP_ERROR_NULL_POINTER;
+    }
+    if (!handle.node) {
+        return FIB_HEAP_ERROR_INVALID_HANDLE;
+    }
+
+    return fib_mpsc_push(queue, FIB_MPSC_OP_DECREASE_KEY, new_key, NULL,
+                         handle.generation, NULL);
+}
+
+// Get the state of a ticket
+fib_mpsc_state_t fib_mpsc_ticket_state(const fib_mpsc_ticket_t* ticket) {
+    if (!ticket) {
+        return FIB_MPSC_FAILED;
+    }
+
+    return (fib_mpsc_state_t)__atomic_load_n(&ticket->state, __ATOMIC_ACQUIRE);
+}
+
+// Wait for a ticket to resolve and return its handle (node NULL if the insert failed)
+fib_mpsc_handle_t fib_mpsc_ticket_wait(const fib_mpsc_ticket_t* ticket) {
+    fib_mpsc_handle_t none = {NULL, 0};
+    fib_mpsc_state_t state;
+    while ((state = fib_mpsc_ticket_state(ticket)) == FIB_MPSC_PENDING) {
+        sched_yield();
+    }
+
+    return state == FIB_MPSC_READY ? ticket->handle : none;
+}
+
+// Apply the queued messages, at most one ring's worth
+//
+// Consecutive inserts are gathered and spliced as one chain. A decrease-key
+// first flushes the inserts before it, so messages apply in ring order.
+size_t fib_mpsc_drain(fib_mpsc_t* queue) {
+    if (!queue) {
+        return 0;
+    }
+
+    size_t applied = 0;
+    size_t pending = 0;
+    while (applied <= queue->mask) {
+        uint64_t position = queue->head;
+        fib_mpsc_slot_t* slot = &queue->slots[position & queue->mask];
+        if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != position + 1) {
+            break;
+        }
+
+        if (slot->op == FIB_MPSC_OP_DECREASE_KEY) {
+            fib_mpsc_flush(queue, pending);
+            pending = 0;
+            fib_mpsc_apply_decrease(queue, slot);
+        } else {
+            queue->batch_keys[pending] = slot->key;
+            queue->batch_data[pending] = slot->data;
+            queue->batch_tickets[pending] = slot->ticket;
+            if (++pending == FIB_MPSC_BATCH) {
+                fib_mpsc_flush(queue, pending);
+                pending = 0;
+            }
+        }
+
+        // The slot's contents are copied out, so producers may reuse it
+        __atomic_store_n(&slot->seq, position + queue->mask + 1, __ATOMIC_RELEASE);
+        queue->head = position + 1;
+        applied++;
+    }
+
+    fib_mpsc_flush(queue, pending);
+    return applied;
+}
+
+// Drain, then get the minimum
+fib_node_t* fib_mpsc_minimum(fib_mpsc_t* queue) {
+    if (!queue) {
+        return NULL;
+    }
+
+    fib_mpsc_drain(queue);
+    return fib_heap_minimum(queue->heap);
+}
+
+// Drain, then extract the minimum
+fib_node_t* fib_mpsc_extract_min(fib_mpsc_t* queue) {
+    if (!queue) {
+        return NULL;
+    }
+
+    fib_mpsc_drain(queue);
+    fib_node_t* node = fib_heap_extract_min(queue->heap);
+    if (node) {
+        fib_mpsc_handle_retire(queue, node);
+    }
+    return node;
+}
+
+// Delete a node and retire its handle
+fib_heap_error_t fib_mpsc_delete_node(fib_mpsc_t* queue, fib_node_t* node) {
+    if (!queue || !node) {
+        return FIB_HEAP_ERROR_NULL_POINTER;
+    }
+
+    fib_heap_error_t result = fib_heap_delete_node(queue->heap, node);
+    if (result == FIB_HEAP_SUCCESS) {
+        fib_mpsc_handle_retire(queue, node);
+    }
+    return result;
+}
+
+// Compact the heap, keeping outstanding handles valid
+fib_heap_error_t fib_mpsc_compact(fib_mpsc_t* queue, size_t budget,
+                                  fib_heap_relocate_fn relocate, void* user_ctx, bool* done) {
+    if (!queue) {
+        return FIB_HEAP_ERROR_NULL_POINTER;
+    }
+
+    fib_mpsc_compact_ctx_t ctx = {queue, relocate, user_ctx};
+    return fib_heap_compact(queue->heap, budget, fib_mpsc_relocate, &ctx, done);
+}
+
+// Get the heap being fed
+fib_heap_t* fib_mpsc_heap(fib_mpsc_t* queue) {
+    return queue ? queue->heap : NULL;
+}
+
+// Get ring counters
+fib_mpsc_stats_t fib_mpsc_get_stats(fib_mpsc_t* queue) {
+    fib_mpsc_stats_t stats = {0, 0, 0, 0, 0, 0};
+    if (queue) {
+        stats = queue->stats;
+        stats.full = __atomic_load_n(&queue->full, __ATOMIC_RELAXED);
+    }
+    return stats;
+}
+
+// Helper function: Claim the next slot and publish a message in it
+static fib_heap_error_t fib_mpsc_push(fib_mpsc_t* queue, int op, int key, void* data,
+                                      uint64_t generation, fib_mpsc_ticket_t* ticket) {
+    uint64_t position = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+    fib_mpsc_slot_t* slot;
+
+    for (;;) {
+        slot = &queue->slots[position & queue->mask];
+        uint64_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        int64_t lag = (int64_t)(seq - position);
+
+        if (lag == 0) {
+            // Free for this position; a failed CAS reloads position
+            if (__atomic_compare_exchange_n(&queue->tail, &position, position + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (lag < 0) {
+            // Still holds the message from one lap ago
+            __atomic_fetch_add(&queue->full, 1, __ATOMIC_RELAXED);
+            return FIB_HEAP_ERROR_INVALID_STATE;
+        } else {
+            // Another producer took this position
+            position = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    slot->op = op;
+    slot->key = key;
+    slot->data = data;
+    slot->generation = generation;
+    slot->ticket = ticket;
+    __atomic_store_n(&slot->seq, position + 1, __ATOMIC_RELEASE);
+    return FIB_HEAP_SUCCESS;
+}
+
+// Helper function: Insert the gathered items and resolve their tickets
+static void fib_mpsc_flush(fib_mpsc_t* queue, size_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    // Room for the handles first, so an inserted node always gets one
+    size_t ticketed = 0;
+    for (size_t i = 0; i < count; i++) {
+        ticketed += queue->batch_tickets[i] != NULL;
+    }
+    if (ticketed && (!fib_hash_reserve(&queue->handles, ticketed) ||
+                     !fib_hash_reserve(&queue->handle_nodes, ticketed))) {
+        // Out of memory for the table: fail the ticketed items like a failed insert
+        size_t kept = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (queue->batch_tickets[i]) {
+                fib_mpsc_resolve(queue->batch_tickets[i], NULL, 0);
+            } else {
+                queue->batch_keys[kept] = queue->batch_keys[i];
+                queue->batch_data[kept] = queue->batch_data[i];
+                queue->batch_tickets[kept] = NULL;
+                kept++;
+            }
+        }
+        count = kept;
+        if (count == 0) {
+            return;
+        }
+    }
+
+    if (fib_heap_insert_batch(queue->heap, queue->batch_keys, queue->batch_data, count,
+                              queue->batch_nodes) == FIB_HEAP_SUCCESS) {
+        queue->stats.batches++;
+        if (count > queue->stats.max_batch) {
+            queue->stats.max_batch = count;
+        }
+    } else {
+        // Out of memory for the whole chain: save what fits one by one
+        for (size_t i = 0; i < count; i++) {
+            queue->batch_nodes[i] = fib_heap_insert(queue->heap, queue->batch_keys[i], queue->batch_data[i]);
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        fib_node_t* node = queue->batch_nodes[i];
+        if (node) {
+            queue->stats.inserts++;
+        }
+        if (queue->batch_tickets[i]) {
+            uint64_t generation = 0;
+            if (node) {
+                generation = queue->next_generation++;
+                fib_mpsc_handle_add(queue, node, generation);
+            }
+            fib_mpsc_resolve(queue->batch_tickets[i], node, generation);
+        }
+    }
+}
+
+// Helper function: Apply a decrease-key if its handle still names a node in the heap
+static void fib_mpsc_apply_decrease(fib_mpsc_t* queue, const fib_mpsc_slot_t* slot) {
+    fib_mpsc_handle_entry_t* entry = (fib_mpsc_handle_entry_t*)fib_hash_find(&queue->handles, slot->generation);
+    if (!entry) {
+        queue->stats.stale++;
+        return;
+    }
+
+    fib_heap_decrease_key(queue->heap, entry->node, slot->key);
+    queue->stats.decreases++;
+}
+
+// Helper function: Hand a handle (or a failure) to the producer's ticket
+static void fib_mpsc_resolve(fib_mpsc_ticket_t* ticket, fib_node_t* node, uint64_t generation) {
+    ticket->handle.node = node;
+    ticket->handle.generation = generation;
+    __atomic_store_n(&ticket->state, node ? FIB_MPSC_READY : FIB_MPSC_FAILED, __ATOMIC_RELEASE);
+}
+
+// Helper function: Look up a ticketed node by address
+static inline fib_mpsc_node_entry_t* fib_mpsc_node_find(fib_mpsc_t* queue, const fib_node_t* node) {
+    return (fib_mpsc_node_entry_t*)fib_hash_find(&queue->handle_nodes, (uint64_t)(uintptr_t)node);
+}
+
+// Helper function: Record a ticketed node in both tables; room must be reserved
+static void fib_mpsc_handle_add(fib_mpsc_t* queue, fib_node_t* node, uint64_t generation) {
+    fib_mpsc_handle_entry_t* handle = (fib_mpsc_handle_entry_t*)fib_hash_add(&queue->handles, generation);
+    handle->node = node;
+    fib_mpsc_node_entry_t* entry =
+        (fib_mpsc_node_entry_t*)fib_hash_add(&queue->handle_nodes, (uint64_t)(uintptr_t)node);
+    entry->generation = generation;
+}
+
+// Helper function: Drop a node that left the heap
+static void fib_mpsc_handle_retire(fib_mpsc_t* queue, const fib_node_t* node) {
+    fib_mpsc_node_entry_t* entry = fib_mpsc_node_find(queue, node);
+    if (entry) {
+        fib_hash_erase(&queue->handles, fib_hash_find(&queue->handles, entry->generation));
+        fib_hash_erase(&queue->handle_nodes, &entry->entry);
+    }
+}
+
+// Helper function: Point a moved node's handle at its new address, then chain to the caller's callback
+//
+// The entries are erased before they are added back, so neither table grows.
+static void fib_mpsc_relocate(fib_node_t* old_node, fib_node_t* new_node, void* user_ctx) {
+    fib_mpsc_compact_ctx_t* ctx = (fib_mpsc_compact_ctx_t*)user_ctx;
+    fib_mpsc_t* queue = ctx->queue;
+    fib_mpsc_node_entry_t* entry = fib_mpsc_node_find(queue, old_node);
+    if (entry) {
+        uint64_t generation = entry->generation;
+        fib_hash_erase(&queue->handle_nodes, &entry->entry);
+        entry = (fib_mpsc_node_entry_t*)fib_hash_add(&queue->handle_nodes, (uint64_t)(uintptr_t)new_node);
+        entry->generation = generation;
+        ((fib_mpsc_handle_entry_t*)fib_hash_find(&queue->handles, generation))->node = new_node;
+    }
+    if (ctx->relocate) {
+        ctx->relocate(old_node, new_node, ctx->user_ctx);
+    }
+}
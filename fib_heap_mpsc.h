@@ -0,0 +1,101 @@
+#ifndef FIB_HEAP_MPSC_H
+#define FIB_HEAP_MPSC_H
+
+#include "fibonacci_heap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Lock-free insert front-end for a heap owned by one consumer thread.
+//
+// Producers never touch the heap: they claim a slot of a bounded ring
+// (Vyukov's array queue: a compare-and-swap on the tail and a sequence
+// number per slot, no locks) and write their insert or decrease-key there.
+// The consumer drains the ring before each minimum or extract-min, feeding
+// runs of inserts to fib_heap_insert_batch so that every run is spliced
+// into the root list as one chain. Messages from one producer are applied
+// in the order it sent them.
+//
+// An insert may carry a ticket, a future that resolves to a handle for the
+// item once the consumer has inserted it. The handle can then be passed to
+// fib_mpsc_decrease_key, which goes through the ring like an insert. A
+// handle carries a generation the consumer never reuses, which it maps to
+// the item's current node; producers never dereference the node address,
+// and the consumer drops a decrease-key whose item has since left the
+// heap, even if the node's memory was reused. For that, ticketed items
+// must leave the heap through fib_mpsc_extract_min or fib_mpsc_delete_node,
+// and the heap must be compacted through fib_mpsc_compact, never with
+// fib_heap_compact directly: compaction moves nodes, and only the
+// front-end's own relocate callback updates the map. The heap itself may
+// only be used by the consumer thread.
+
+typedef struct fib_mpsc fib_mpsc_t;
+
+// Names a ticketed item for fib_mpsc_decrease_key; node is NULL for none
+typedef struct {
+    const void* node;           // The node when the ticket resolved; fib_mpsc_compact may move it
+    uint64_t generation;        // Identity of the item
+} fib_mpsc_handle_t;
+
+// State of a ticket
+typedef enum {
+    FIB_MPSC_PENDING = 0,       // Still in the ring
+    FIB_MPSC_READY,             // Inserted; handle is set
+    FIB_MPSC_FAILED             // The consumer could not allocate the node
+} fib_mpsc_state_t;
+
+// Future for the handle of a queued insert. Owned by the producer, which
+// must keep it alive until it resolves; read it through the functions below.
+typedef struct {
+    fib_mpsc_handle_t handle;
+    int state;                  // fib_mpsc_state_t, written by the consumer
+} fib_mpsc_ticket_t;
+
+// Ring counters
+typedef struct {
+    uint64_t inserts;           // Inserts applied by the consumer
+    uint64_t decreases;         // Decrease-keys applied (including ones the heap rejected)
+    uint64_t stale;             // Decrease-keys dropped because the item had left the heap
+    uint64_t batches;           // Chains spliced by fib_heap_insert_batch
+    uint64_t full;              // Producer calls refused because the ring was full
+    size_t max_batch;           // Largest chain spliced at once
+} fib_mpsc_stats_t;
+
+// Front-end creation and destruction. capacity is rounded up to a power of
+// two (0 = 64K slots). Destroy discards queued messages; pending tickets
+// never resolve, and the heap is left to its owner.
+fib_mpsc_t* fib_mpsc_create(fib_heap_t* heap, size_t capacity);
+void fib_mpsc_destroy(fib_mpsc_t* queue);
+
+// Producer side, from any thread. Both return FIB_HEAP_ERROR_INVALID_STATE
+// without blocking when the ring is full. ticket may be NULL.
+fib_heap_error_t fib_mpsc_insert(fib_mpsc_t* queue, int key, void* data, fib_mpsc_ticket_t* ticket);
+fib_heap_error_t fib_mpsc_decrease_key(fib_mpsc_t* queue, fib_mpsc_handle_t handle, int new_key);
+
+// Ticket inquiry, from any thread. wait spins (yielding) until the ticket
+// resolves and returns its handle, whose node is NULL if the insert failed.
+fib_mpsc_state_t fib_mpsc_ticket_state(const fib_mpsc_ticket_t* ticket);
+fib_mpsc_handle_t fib_mpsc_ticket_wait(const fib_mpsc_ticket_t* ticket);
+
+// Consumer side, from the owning thread only. drain applies every message
+// queued so far and returns how many it applied. delete_node removes a node
+// without draining first and retires its handle. compact runs
+// fib_heap_compact on the heap, moving each handle to its item's new node
+// before calling relocate (which may be NULL); it does not drain.
+size_t fib_mpsc_drain(fib_mpsc_t* queue);
+fib_node_t* fib_mpsc_minimum(fib_mpsc_t* queue);
+fib_node_t* fib_mpsc_extract_min(fib_mpsc_t* queue);
+fib_heap_error_t fib_mpsc_delete_node(fib_mpsc_t* queue, fib_node_t* node);
+fib_heap_error_t fib_mpsc_compact(fib_mpsc_t* queue, size_t budget,
+                                  fib_heap_relocate_fn relocate, void* user_ctx, bool* done);
+
+// Status inquiry
+fib_heap_t* fib_mpsc_heap(fib_mpsc_t* queue);
+fib_mpsc_stats_t fib_mpsc_get_stats(fib_mpsc_t* queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIB_HEAP_MPSC_H
@@ -0,0 +1,41 @@
+#ifndef FIB_HEAP_PROBES_H
+#define FIB_HEAP_PROBES_H
+
+// Static tracepoints (USDT) on the heap's hot paths.
+//
+// Built with -DFIB_HEAP_USDT (make usdt), each probe is a <sys/sdt.h>
+// marker: one nop in the instruction stream plus an ELF note telling
+// bpftrace, perf or SystemTap where to patch in a breakpoint and where the
+// arguments are. An unattached probe costs the nop and keeping its
+// arguments in registers. Without the define the macros expand to nothing
+// and their arguments are not evaluated. See bpftrace/ for example scripts.
+//
+// Provider "fibheap":
+//   insert(heap, key, size)                      once per batch for insert_batch,
+//                                                with the batch's smallest key
+//   extract_min_entry(heap, size)
+//   extract_min_return(heap, node, key, size)    node is 0 for an empty heap
+//   consolidate(heap, roots, links)              roots walked, links performed
+//   decrease_key_cut(heap, node, new_key, depth) depth = ancestors cascaded
+//   union(heap1, heap2, nodes)                   nodes moved into heap1
+
+#ifdef FIB_HEAP_USDT
+#if defined(__has_include)
+#if !__has_include(<sys/sdt.h>)
+#error "FIB_HEAP_USDT needs <sys/sdt.h> (systemtap-sdt-dev or systemtap-sdt-devel)"
+#endif
+#endif
+#include <sys/sdt.h>
+
+#define FIB_HEAP_PROBE2(name, a, b) DTRACE_PROBE2(fibheap, name, a, b)
+#define FIB_HEAP_PROBE3(name, a, b, c) DTRACE_PROBE3(fibheap, name, a, b, c)
+#define FIB_HEAP_PROBE4(name, a, b, c, d) DTRACE_PROBE4(fibheap, name, a, b, c, d)
+#else
+// sizeof keeps locals that only feed a probe from being reported as unused
+#define FIB_HEAP_PROBE2(name, a, b) ((void)sizeof(a), (void)sizeof(b))
+#define FIB_HEAP_PROBE3(name, a, b, c) ((void)sizeof(a), (void)sizeof(b), (void)sizeof(c))
+#define FIB_HEAP_PROBE4(name, a, b, c, d) \
+    ((void)sizeof(a), (void)sizeof(b), (void)sizeof(c), (void)sizeof(d))
+#endif
+
+#endif // FIB_HEAP_PROBES_H
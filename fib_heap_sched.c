@@ -0,0 +1,398 @@
+#define _GNU_SOURCE
+#include "fib_heap_sched.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+// Constants
+#define FIB_SCHED_CACHE_LINE 64
+#define FIB_SCHED_EMPTY INT64_MAX      // Published by workers holding no tasks
+#define FIB_SCHED_STEAL_ATTEMPTS 4
+
+// Queued task, stored as node data
+typedef struct {
+    fib_task_fn fn;
+    void* user_ctx;
+} fib_sched_task_t;
+
+// Per-worker state, one cache line apart so publishing does not false-share
+typedef struct {
+    pthread_mutex_t lock;       // Guards heap
+    fib_heap_t* heap;           // Pending tasks keyed by priority
+    int64_t published;          // Best priority held, or FIB_SCHED_EMPTY (atomic)
+    size_t tasks_run;           // Counters, written by the owner only (atomic)
+    size_t steals;
+    size_t stolen_tasks;
+    size_t inversion_steals;
+    pthread_t thread;
+    fib_sched_t* sched;
+    size_t index;
+} __attribute__((aligned(FIB_SCHED_CACHE_LINE))) fib_sched_worker_t;
+
+struct fib_sched {
+    fib_sched_worker_t* workers;
+    size_t worker_count;
+    int inversion_bound;
+
+    size_t pending;             // Submitted and not yet finished (atomic)
+    size_t queued;              // Sitting in some heap (atomic)
+    size_t sleepers;            // Workers blocked on work_cond (atomic)
+    size_t next_worker;         // Round-robin cursor for FIB_SCHED_ANY_WORKER (atomic)
+    bool stopping;              // Set under idle_lock, polled without it (atomic)
+
+    pthread_mutex_t idle_lock;  // Guards sleeping and stopping
+    pthread_cond_t work_cond;   // Signalled when work arrives
+    pthread_cond_t idle_cond;   // Broadcast when pending drops to zero
+};
+
+// Helper function prototypes
+static void* fib_sched_worker_main(void* arg);
+static fib_sched_task_t* fib_sched_next(fib_sched_t* sched, fib_sched_worker_t* self);
+static fib_sched_task_t* fib_sched_steal_and_take(fib_sched_worker_t* self, fib_sched_worker_t* victim,
+                                                  bool inversion);
+static fib_sched_worker_t* fib_sched_best_victim(fib_sched_t* sched, fib_sched_worker_t* self,
+                                                 int64_t* best);
+static fib_sched_task_t* fib_sched_take_min(fib_sched_worker_t* worker);
+static void fib_sched_publish(fib_sched_worker_t* worker);
+static void fib_sched_discard(fib_sched_worker_t* worker);
+
+// Create a scheduler and start its worker threads
+fib_sched_t* fib_sched_create(size_t workers, int inversion_bound) {
+    if (workers == 0 || inversion_bound < 0) {
+        return NULL;
+    }
+
+    fib_sched_t* sched = (fib_sched_t*)calloc(1, sizeof(fib_sched_t));
+    if (!sched) {
+        return NULL;
+    }
+
+    void* memory = NULL;
+    if (posix_memalign(&memory, FIB_SCHED_CACHE_LINE, workers * sizeof(fib_sched_worker_t)) != 0) {
+        free(sched);
+        return NULL;
+    }
+    sched->workers = (fib_sched_worker_t*)memory;
+    sched->inversion_bound = inversion_bound;
+    pthread_mutex_init(&sched->idle_lock, NULL);
+    pthread_cond_init(&sched->work_cond, NULL);
+    pthread_cond_init(&sched->idle_cond, NULL);
+
+    for (size_t i = 0; i < workers; i++) {
+        fib_sched_worker_t* worker = &sched->workers[i];
+        pthread_mutex_init(&worker->lock, NULL);
+        worker->heap = fib_heap_create();
+        worker->published = FIB_SCHED_EMPTY;
+        worker->tasks_run = 0;
+        worker->steals = 0;
+        worker->stolen_tasks = 0;
+        worker->inversion_steals = 0;
+        worker->sched = sched;
+        worker->index = i;
+        if (!worker->heap) {
+            pthread_mutex_destroy(&worker->lock);
+            break;
+        }
+        sched->worker_count = i + 1;
+    }
+
+    // Threads only start once every heap exists, since they steal from each other
+    bool started = sched->worker_count == workers;
+    size_t running = 0;
+    for (; started && running < workers; running++) {
+        if (pthread_create(&sched->workers[running].thread, NULL, fib_sched_worker_main,
+                           &sched->workers[running]) != 0) {
+            started = false;
+            break;
+        }
+    }
+
+    if (!started) {
+        pthread_mutex_lock(&sched->idle_lock);
+        __atomic_store_n(&sched->stopping, true, __ATOMIC_RELAXED);
+        pthread_cond_broadcast(&sched->work_cond);
+        pthread_mutex_unlock(&sched->idle_lock);
+        for (size_t i = 0; i < running; i++) {
+            pthread_join(sched->workers[i].thread, NULL);
+        }
+        for (size_t i = 0; i < sched->worker_count; i++) {
+            fib_heap_destroy(sched->workers[i].heap);
+            pthread_mutex_destroy(&sched->workers[i].lock);
+        }
+        pthread_cond_destroy(&sched->idle_cond);
+        pthread_cond_destroy(&sched->work_cond);
+        pthread_mutex_destroy(&sched->idle_lock);
+        free(sched->workers);
+        free(sched);
+        return NULL;
+    }
+
+    return sched;
+}
+
+// Stop the workers and free the scheduler
+void fib_sched_destroy(fib_sched_t* sched) {
+    if (!sched) {
+        return;
+    }
+
+    pthread_mutex_lock(&sched->idle_lock);
+    __atomic_store_n(&sched->stopping, true, __ATOMIC_RELAXED);
+    pthread_cond_broadcast(&sched->work_cond);
+    pthread_mutex_unlock(&sched->idle_lock);
+
+    for (size_t i = 0; i < sched->worker_count; i++) {
+        pthread_join(sched->workers[i].thread, NULL);
+    }
+
+    for (size_t i = 0; i < sched->worker_count; i++) {
+        fib_sched_discard(&sched->workers[i]);
+        fib_heap_destroy(sched->workers[i].heap);
+        pthread_mutex_destroy(&sched->workers[i].lock);
+    }
+
+    pthread_cond_destroy(&sched->idle_cond);
+    pthread_cond_destroy(&sched->work_cond);
+    pthread_mutex_destroy(&sched->idle_lock);
+    free(sched->workers);
+    free(sched);
+}
+
+// Queue a task
+fib_heap_error_t fib_sched_submit(fib_sched_t* sched, size_t worker, int priority,
+                                  fib_task_fn task, void* user_ctx) {
+    if (!sched || !task) {
+        return FIB_HEAP_ERROR_NULL_POINTER;
+    }
+
+    if (worker == FIB_SCHED_ANY_WORKER) {
+        worker = __atomic_fetch_add(&sched->next_worker, 1, __ATOMIC_RELAXED) % sched->worker_count;
+    } else if (worker >= sched->worker_count) {
+        return FIB_HEAP_ERROR_INVALID_HANDLE;
+    }
+
+    fib_sched_task_t* entry = (fib_sched_task_t*)malloc(sizeof(fib_sched_task_t));
+    if (!entry) {
+        return FIB_HEAP_ERROR_OUT_OF_MEMORY;
+    }
+    entry->fn = task;
+    entry->user_ctx = user_ctx;
+
+    fib_sched_worker_t* target = &sched->workers[worker];
+    __atomic_fetch_add(&sched->pending, 1, __ATOMIC_SEQ_CST);
+
+    pthread_mutex_lock(&target->lock);
+    fib_node_t* node = fib_heap_insert(target->heap, priority, entry);
+    if (node && (int64_t)priority < __atomic_load_n(&target->published, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&target->published, (int64_t)priority, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&target->lock);
+
+    if (!node) {
+        __atomic_fetch_sub(&sched->pending, 1, __ATOMIC_SEQ_CST);
+        free(entry);
+        return FIB_HEAP_ERROR_OUT_OF_MEMORY;
+    }
+
+    // Pairs with the sleeper check in fib_sched_worker_main: either the
+    // worker sees queued > 0 or we see it registered as a sleeper
+    __atomic_fetch_add(&sched->queued, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&sched->sleepers, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&sched->idle_lock);
+        pthread_cond_signal(&sched->work_cond);
+        pthread_mutex_unlock(&sched->idle_lock);
+    }
+
+    return FIB_HEAP_SUCCESS;
+}
+
+// Wait until no task is queued or running
+void fib_sched_wait_idle(fib_sched_t* sched) {
+    if (!sched) {
+        return;
+    }
+
+    pthread_mutex_lock(&sched->idle_lock);
+    while (__atomic_load_n(&sched->pending, __ATOMIC_SEQ_CST) > 0) {
+        pthread_cond_wait(&sched->idle_cond, &sched->idle_lock);
+    }
+    pthread_mutex_unlock(&sched->idle_lock);
+}
+
+// Get number of worker threads
+size_t fib_sched_workers(fib_sched_t* sched) {
+    return sched ? sched->worker_count : 0;
+}
+
+// Get counters summed over workers
+fib_sched_stats_t fib_sched_get_stats(fib_sched_t* sched) {
+    fib_sched_stats_t stats = {0, 0, 0, 0};
+    if (!sched) {
+        return stats;
+    }
+
+    for (size_t i = 0; i < sched->worker_count; i++) {
+        fib_sched_worker_t* worker = &sched->workers[i];
+        stats.tasks_run += __atomic_load_n(&worker->tasks_run, __ATOMIC_RELAXED);
+        stats.steals += __atomic_load_n(&worker->steals, __ATOMIC_RELAXED);
+        stats.stolen_tasks += __atomic_load_n(&worker->stolen_tasks, __ATOMIC_RELAXED);
+        stats.inversion_steals += __atomic_load_n(&worker->inversion_steals, __ATOMIC_RELAXED);
+    }
+    return stats;
+}
+
+// Helper function: Worker thread body
+static void* fib_sched_worker_main(void* arg) {
+    fib_sched_worker_t* self = (fib_sched_worker_t*)arg;
+    fib_sched_t* sched = self->sched;
+
+    for (;;) {
+        fib_sched_task_t* task = fib_sched_next(sched, self);
+        if (task) {
+            task->fn(sched, self->index, task->user_ctx);
+            free(task);
+            __atomic_fetch_add(&self->tasks_run, 1, __ATOMIC_RELAXED);
+
+            if (__atomic_sub_fetch(&sched->pending, 1, __ATOMIC_SEQ_CST) == 0) {
+                pthread_mutex_lock(&sched->idle_lock);
+                pthread_cond_broadcast(&sched->idle_cond);
+                pthread_mutex_unlock(&sched->idle_lock);
+            }
+            continue;
+        }
+
+        pthread_mutex_lock(&sched->idle_lock);
+        if (sched->stopping) {
+            pthread_mutex_unlock(&sched->idle_lock);
+            return NULL;
+        }
+        __atomic_fetch_add(&sched->sleepers, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&sched->queued, __ATOMIC_SEQ_CST) == 0) {
+            pthread_cond_wait(&sched->work_cond, &sched->idle_lock);
+        }
+        __atomic_fetch_sub(&sched->sleepers, 1, __ATOMIC_SEQ_CST);
+        bool stop = sched->stopping;
+        pthread_mutex_unlock(&sched->idle_lock);
+        if (stop) {
+            return NULL;
+        }
+    }
+}
+
+// Helper function: Pick the next task for a worker, stealing when needed
+static fib_sched_task_t* fib_sched_next(fib_sched_t* sched, fib_sched_worker_t* self) {
+    for (int attempt = 0; attempt < FIB_SCHED_STEAL_ATTEMPTS; attempt++) {
+        if (__atomic_load_n(&sched->stopping, __ATOMIC_RELAXED)) {
+            return NULL;
+        }
+
+        int64_t best = FIB_SCHED_EMPTY;
+        fib_sched_worker_t* victim = fib_sched_best_victim(sched, self, &best);
+
+        // Run the local minimum unless it is too far behind another worker's
+        int64_t own = __atomic_load_n(&self->published, __ATOMIC_RELAXED);
+        if (own != FIB_SCHED_EMPTY && (!victim || own <= best + sched->inversion_bound)) {
+            pthread_mutex_lock(&self->lock);
+            fib_sched_task_t* task = fib_sched_take_min(self);
+            pthread_mutex_unlock(&self->lock);
+            if (task) {
+                return task;
+            }
+        }
+
+        if (!victim) {
+            if (own == FIB_SCHED_EMPTY) {
+                return NULL;
+            }
+            continue;
+        }
+
+        fib_sched_task_t* task = fib_sched_steal_and_take(self, victim, own != FIB_SCHED_EMPTY);
+        if (task) {
+            return task;
+        }
+    }
+
+    // Stealing kept losing races; fall back to local work to guarantee progress
+    pthread_mutex_lock(&self->lock);
+    fib_sched_task_t* task = fib_sched_take_min(self);
+    pthread_mutex_unlock(&self->lock);
+    return task;
+}
+
+// Helper function: Move the victim's best trees to self and take the new minimum
+static fib_sched_task_t* fib_sched_steal_and_take(fib_sched_worker_t* self, fib_sched_worker_t* victim,
+                                                  bool inversion) {
+    // Lock in index order so two workers stealing from each other cannot deadlock
+    fib_sched_worker_t* first = self->index < victim->index ? self : victim;
+    fib_sched_worker_t* second = self->index < victim->index ? victim : self;
+    pthread_mutex_lock(&first->lock);
+    pthread_mutex_lock(&second->lock);
+
+    // Take about half the victim's tasks, best trees first
+    size_t victim_size = fib_heap_size(victim->heap);
+    size_t stolen = 0;
+    if (victim_size > 0) {
+        fib_heap_steal(self->heap, victim->heap, victim_size / 2 + 1, &stolen);
+        fib_sched_publish(victim);
+    }
+    fib_sched_task_t* task = fib_sched_take_min(self);
+
+    pthread_mutex_unlock(&second->lock);
+    pthread_mutex_unlock(&first->lock);
+
+    if (stolen > 0) {
+        __atomic_fetch_add(&self->steals, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&self->stolen_tasks, stolen, __ATOMIC_RELAXED);
+        if (inversion) {
+            __atomic_fetch_add(&self->inversion_steals, 1, __ATOMIC_RELAXED);
+        }
+    }
+    return task;
+}
+
+// Helper function: Find the other worker publishing the best priority
+static fib_sched_worker_t* fib_sched_best_victim(fib_sched_t* sched, fib_sched_worker_t* self,
+                                                 int64_t* best) {
+    fib_sched_worker_t* victim = NULL;
+    *best = FIB_SCHED_EMPTY;
+
+    // Start after self so ties spread across victims instead of piling on worker 0
+    for (size_t n = 1; n < sched->worker_count; n++) {
+        fib_sched_worker_t* worker = &sched->workers[(self->index + n) % sched->worker_count];
+        int64_t published = __atomic_load_n(&worker->published, __ATOMIC_RELAXED);
+        if (published < *best) {
+            *best = published;
+            victim = worker;
+        }
+    }
+    return victim;
+}
+
+// Helper function: Extract the local minimum; caller holds worker->lock
+static fib_sched_task_t* fib_sched_take_min(fib_sched_worker_t* worker) {
+    fib_node_t* node = fib_heap_extract_min(worker->heap);
+    fib_sched_publish(worker);
+    if (!node) {
+        return NULL;
+    }
+
+    fib_sched_task_t* task = (fib_sched_task_t*)node->data;
+    fib_heap_free_node(worker->heap, node);
+    __atomic_fetch_sub(&worker->sched->queued, 1, __ATOMIC_SEQ_CST);
+    return task;
+}
+
+// Helper function: Publish the best priority held; caller holds worker->lock
+static void fib_sched_publish(fib_sched_worker_t* worker) {
+    fib_node_t* min = fib_heap_minimum(worker->heap);
+    __atomic_store_n(&worker->published, min ? (int64_t)min->key : FIB_SCHED_EMPTY, __ATOMIC_RELAXED);
+}
+
+// Helper function: Free tasks that never ran
+static void fib_sched_discard(fib_sched_worker_t* worker) {
+    fib_node_t* node;
+    while ((node = fib_heap_extract_min(worker->heap)) != NULL) {
+        free(node->data);
+        fib_heap_free_node(worker->heap, node);
+    }
+}
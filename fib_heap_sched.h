@@ -0,0 +1,58 @@
+#ifndef FIB_HEAP_SCHED_H
+#define FIB_HEAP_SCHED_H
+
+#include "fibonacci_heap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Work-stealing priority task scheduler.
+//
+// Every worker thread owns a Fibonacci heap of pending tasks (smaller
+// priority runs first) guarded by its own mutex, so workers never contend
+// on a shared queue. Each worker publishes the best priority it holds. An
+// idle worker steals the best root trees of the worker holding the best
+// published priority (fib_heap_steal); a busy worker does the same instead
+// of running its own minimum when that minimum is more than
+// `inversion_bound` worse than the best published elsewhere. Publication is
+// racy by design, so the bound holds up to tasks submitted concurrently
+// with the decision.
+
+typedef struct fib_sched fib_sched_t;
+
+// Task body; `worker` is the index of the running worker, for local submits
+typedef void (*fib_task_fn)(fib_sched_t* sched, size_t worker, void* user_ctx);
+
+// Submit target for callers that are not running on a worker
+#define FIB_SCHED_ANY_WORKER ((size_t)-1)
+
+// Scheduler counters, summed over workers
+typedef struct {
+    size_t tasks_run;           // Task bodies executed
+    size_t steals;              // Successful steal operations
+    size_t stolen_tasks;        // Tasks moved by those steals
+    size_t inversion_steals;    // Steals by busy workers enforcing the bound
+} fib_sched_stats_t;
+
+// Scheduler creation and destruction. Workers start immediately; destroy
+// stops them after their current task and discards tasks not yet run.
+fib_sched_t* fib_sched_create(size_t workers, int inversion_bound);
+void fib_sched_destroy(fib_sched_t* sched);
+
+// Queue a task on a worker's heap (FIB_SCHED_ANY_WORKER spreads round-robin)
+fib_heap_error_t fib_sched_submit(fib_sched_t* sched, size_t worker, int priority,
+                                  fib_task_fn task, void* user_ctx);
+
+// Block until every submitted task, including ones they submit, has run
+void fib_sched_wait_idle(fib_sched_t* sched);
+
+// Status inquiry
+size_t fib_sched_workers(fib_sched_t* sched);
+fib_sched_stats_t fib_sched_get_stats(fib_sched_t* sched);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIB_HEAP_SCHED_H
@@ -0,0 +1,564 @@
+#define _GNU_SOURCE
+#include "fib_heap_shm.h"
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+
+// Constants
+#define FIB_SHM_MAGIC 0x46494248534d3031ULL   // "FIBHSM01"
+#define FIB_SHM_VERSION 2
+#define FIB_SHM_MAX_DEGREE 64
+#define FIB_SHM_ALIGN 64
+
+// Handles: slot offset in the low bits, slot generation above it
+#define FIB_SHM_OFFSET_BITS 40
+#define FIB_SHM_OFFSET_MASK (((uint64_t)1 << FIB_SHM_OFFSET_BITS) - 1)
+#define FIB_SHM_GENERATION_MASK (((uint64_t)1 << (64 - FIB_SHM_OFFSET_BITS)) - 1)
+
+// Node slot stored inside the region
+typedef struct {
+    int32_t key;                // Node's key value
+    int32_t degree;             // Number of children
+    uint8_t marked;             // Mark for cascading cut
+    uint8_t in_use;             // Slot currently holds a live node
+    uint8_t pad[2];
+    uint32_t generation;        // Bumped each time the slot is freed
+    uint64_t value;             // User payload
+
+    fib_shm_off_t parent;       // Parent node
+    fib_shm_off_t child;        // One of the child nodes
+    fib_shm_off_t left;         // Left sibling
+    fib_shm_off_t right;        // Right sibling (doubles as free-list link)
+} fib_shm_node_t;
+
+// Region header, always at offset 0 of the region
+struct fib_shm_heap {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t node_size;
+    uint64_t region_size;
+
+    pthread_mutex_t lock;       // Process-shared robust mutex
+
+    fib_shm_off_t min_node;     // Offset of minimum node
+    uint64_t node_count;        // Total number of live nodes
+    uint64_t owner_deaths;      // Times the forest was rebuilt after an owner died
+
+    // Region allocator: recycled slots first, then never-used slots
+    fib_shm_off_t free_list;
+    uint64_t node_base;         // Offset of slot 0
+    uint64_t next_slot;         // Index of first never-used slot
+    uint64_t slot_count;        // Total number of slots
+
+    fib_shm_off_t degree_table[FIB_SHM_MAX_DEGREE];
+};
+
+#define FIB_SHM_NODE(heap, off) ((fib_shm_node_t*)((char*)(heap) + (off)))
+
+// Helper function prototypes
+static uint64_t fib_shm_header_size(void);
+static int fib_shm_lock(fib_shm_heap_t* heap);
+static void fib_shm_unlock(fib_shm_heap_t* heap);
+static bool fib_shm_valid_handle(fib_shm_heap_t* heap, fib_shm_off_t handle);
+static void fib_shm_rebuild(fib_shm_heap_t* heap);
+static fib_shm_off_t fib_shm_node_alloc(fib_shm_heap_t* heap);
+static void fib_shm_node_free(fib_shm_heap_t* heap, fib_shm_off_t off);
+static void fib_shm_list_remove(fib_shm_heap_t* heap, fib_shm_off_t off);
+static void fib_shm_add_to_root_list(fib_shm_heap_t* heap, fib_shm_off_t off);
+static void fib_shm_link(fib_shm_heap_t* heap, fib_shm_off_t child, fib_shm_off_t parent);
+static void fib_shm_consolidate(fib_shm_heap_t* heap);
+static void fib_shm_cut(fib_shm_heap_t* heap, fib_shm_off_t x, fib_shm_off_t y);
+static void fib_shm_cascading_cut(fib_shm_heap_t* heap, fib_shm_off_t y);
+static fib_shm_off_t fib_shm_extract_min_locked(fib_shm_heap_t* heap);
+
+static uint64_t fib_shm_header_size(void) {
+    return (sizeof(fib_shm_heap_t) + FIB_SHM_ALIGN - 1) & ~(uint64_t)(FIB_SHM_ALIGN - 1);
+}
+
+// Region size needed to hold max_nodes live nodes
+size_t fib_shm_heap_region_size(size_t max_nodes) {
+    return (size_t)fib_shm_header_size() + max_nodes * sizeof(fib_shm_node_t);
+}
+
+// Initialize a fresh heap at the start of region
+fib_shm_heap_t* fib_shm_heap_init(void* region, size_t region_size) {
+    if (!region || region_size < fib_shm_heap_region_size(1) || region_size > FIB_SHM_OFFSET_MASK) {
+        return NULL;
+    }
+
+    fib_shm_heap_t* heap = (fib_shm_heap_t*)region;
+    memset(heap, 0, sizeof(*heap));
+
+    pthread_mutexattr_t attr;
+    if (pthread_mutexattr_init(&attr) != 0) {
+        return NULL;
+    }
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    int rc = pthread_mutex_init(&heap->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    if (rc != 0) {
+        return NULL;
+    }
+
+    heap->version = FIB_SHM_VERSION;
+    heap->node_size = sizeof(fib_shm_node_t);
+    heap->region_size = region_size;
+    heap->min_node = FIB_SHM_NULL;
+    heap->free_list = FIB_SHM_NULL;
+    heap->node_base = fib_shm_header_size();
+    heap->next_slot = 0;
+    heap->slot_count = (region_size - heap->node_base) / sizeof(fib_shm_node_t);
+
+    // Publish last so attaching processes never see a half-built header
+    __atomic_store_n(&heap->magic, FIB_SHM_MAGIC, __ATOMIC_RELEASE);
+    return heap;
+}
+
+// Attach to a heap initialized by another process
+fib_shm_heap_t* fib_shm_heap_attach(void* region) {
+    if (!region) {
+        return NULL;
+    }
+
+    fib_shm_heap_t* heap = (fib_shm_heap_t*)region;
+    if (__atomic_load_n(&heap->magic, __ATOMIC_ACQUIRE) != FIB_SHM_MAGIC ||
+        heap->version != FIB_SHM_VERSION ||
+        heap->node_size != sizeof(fib_shm_node_t)) {
+        return NULL;
+    }
+
+    return heap;
+}
+
+// Helper function: Acquire the region lock, recovering from a dead owner
+static int fib_shm_lock(fib_shm_heap_t* heap) {
+    int rc = pthread_mutex_lock(&heap->lock);
+    if (rc == EOWNERDEAD) {
+        // The previous owner died inside a critical section, possibly halfway
+        // through a link or cut, so the forest cannot be trusted. Rebuild it
+        // from the slots before anyone uses it again.
+        fib_shm_rebuild(heap);
+        heap->owner_deaths++;
+        rc = pthread_mutex_consistent(&heap->lock);
+        if (rc != 0) {
+            pthread_mutex_unlock(&heap->lock);
+        }
+    }
+    return rc;
+}
+
+static void fib_shm_unlock(fib_shm_heap_t* heap) {
+    pthread_mutex_unlock(&heap->lock);
+}
+
+// Helper function: Check that a handle refers to the node it was issued for
+//
+// A slot that was freed and reused has a newer generation, so stale handles
+// are rejected rather than aliasing the new node.
+static bool fib_shm_valid_handle(fib_shm_heap_t* heap, fib_shm_off_t handle) {
+    fib_shm_off_t off = handle & FIB_SHM_OFFSET_MASK;
+    if (off < heap->node_base) {
+        return false;
+    }
+    uint64_t rel = off - heap->node_base;
+    if (rel % sizeof(fib_shm_node_t) != 0 || rel / sizeof(fib_shm_node_t) >= heap->next_slot) {
+        return false;
+    }
+    fib_shm_node_t* node = FIB_SHM_NODE(heap, off);
+    return node->in_use != 0 &&
+           (node->generation & FIB_SHM_GENERATION_MASK) == handle >> FIB_SHM_OFFSET_BITS;
+}
+
+// Helper function: Rebuild the forest from the slots after an owner died
+//
+// Parent, child, sibling and degree fields may be half rewritten, and the
+// free list may have lost its head. Only the in_use flags are trusted: each
+// live slot becomes a lone root, every other slot below next_slot goes back
+// on the free list, and one consolidation restores heap order. A node that
+// the dead owner had unlinked but not yet freed stays in the heap.
+static void fib_shm_rebuild(fib_shm_heap_t* heap) {
+    heap->min_node = FIB_SHM_NULL;
+    heap->free_list = FIB_SHM_NULL;
+    uint64_t live = 0;
+
+    for (uint64_t i = heap->next_slot; i-- > 0;) {
+        fib_shm_off_t off = heap->node_base + i * sizeof(fib_shm_node_t);
+        fib_shm_node_t* node = FIB_SHM_NODE(heap, off);
+        if (!node->in_use) {
+            node->right = heap->free_list;
+            heap->free_list = off;
+            continue;
+        }
+
+        node->parent = FIB_SHM_NULL;
+        node->child = FIB_SHM_NULL;
+        node->degree = 0;
+        node->marked = 0;
+        fib_shm_add_to_root_list(heap, off);
+        if (node->key < FIB_SHM_NODE(heap, heap->min_node)->key) {
+            heap->min_node = off;
+        }
+        live++;
+    }
+
+    __atomic_store_n(&heap->node_count, live, __ATOMIC_RELAXED);
+    if (heap->min_node != FIB_SHM_NULL) {
+        fib_shm_consolidate(heap);
+    }
+}
+
+// Helper function: Take a slot from the region allocator
+static fib_shm_off_t fib_shm_node_alloc(fib_shm_heap_t* heap) {
+    fib_shm_off_t off = heap->free_list;
+    if (off != FIB_SHM_NULL) {
+        heap->free_list = FIB_SHM_NODE(heap, off)->right;
+        return off;
+    }
+
+    if (heap->next_slot >= heap->slot_count) {
+        return FIB_SHM_NULL;
+    }
+
+    // A fresh slot must read as free before next_slot covers it, in case
+    // this process dies before the node is initialized
+    off = heap->node_base + heap->next_slot * sizeof(fib_shm_node_t);
+    fib_shm_node_t* node = FIB_SHM_NODE(heap, off);
+    node->in_use = 0;
+    node->generation = 0;
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    heap->next_slot++;
+    return off;
+}
+
+// Helper function: Return a slot to the region allocator
+static void fib_shm_node_free(fib_shm_heap_t* heap, fib_shm_off_t off) {
+    fib_shm_node_t* node = FIB_SHM_NODE(heap, off);
+    node->in_use = 0;
+    node->generation++;
+    node->right = heap->free_list;
+    heap->free_list = off;
+}
+
+// Helper function: Remove node from its list
+static void fib_shm_list_remove(fib_shm_heap_t* heap, fib_shm_off_t off) {
+    fib_shm_node_t* node = FIB_SHM_NODE(heap, off);
+    FIB_SHM_NODE(heap, node->left)->right = node->right;
+    FIB_SHM_NODE(heap, node->right)->left = node->left;
+}
+
+// Helper function: Add node to root list
+static void fib_shm_add_to_root_list(fib_shm_heap_t* heap, fib_shm_off_t off) {
+    fib_shm_node_t* node = FIB_SHM_NODE(heap, off);
+    if (heap->min_node == FIB_SHM_NULL) {
+        heap->min_node = off;
+        node->left = node->right = off;
+    } else {
+        fib_shm_node_t* min = FIB_SHM_NODE(heap, heap->min_node);
+        node->right = min->right;
+        node->left = heap->min_node;
+        FIB_SHM_NODE(heap, min->right)->left = off;
+        min->right = off;
+    }
+}
+
+// Helper function: Link child under parent
+static void fib_shm_link(fib_shm_heap_t* heap, fib_shm_off_t child, fib_shm_off_t parent) {
+    fib_shm_node_t* c = FIB_SHM_NODE(heap, child);
+    fib_shm_node_t* p = FIB_SHM_NODE(heap, parent);
+
+    fib_shm_list_remove(heap, child);
+
+    c->parent = parent;
+    if (p->child == FIB_SHM_NULL) {
+        p->child = child;
+        c->left = c->right = child;
+    } else {
+        fib_shm_node_t* first = FIB_SHM_NODE(heap, p->child);
+        c->right = first->right;
+        c->left = p->child;
+        FIB_SHM_NODE(heap, first->right)->left = child;
+        first->right = child;
+    }
+
+    p->degree++;
+    c->marked = 0;
+}
+
+// Helper function: Consolidate the root list in place
+//
+// The degree table lives in the header, so no scratch memory is needed. Each
+// root's successor is saved before processing; linking only ever removes the
+// current root or an already-processed root from the list.
+static void fib_shm_consolidate(fib_shm_heap_t* heap) {
+    fib_shm_off_t* table = heap->degree_table;
+    memset(table, 0, sizeof(heap->degree_table));
+
+    size_t root_count = 0;
+    fib_shm_off_t current = heap->min_node;
+    do {
+        root_count++;
+        current = FIB_SHM_NODE(heap, current)->right;
+    } while (current != heap->min_node);
+
+    current = heap->min_node;
+    for (size_t i = 0; i < root_count; i++) {
+        fib_shm_off_t next = FIB_SHM_NODE(heap, current)->right;
+        fib_shm_off_t x = current;
+        int d = FIB_SHM_NODE(heap, x)->degree;
+
+        while (table[d] != FIB_SHM_NULL) {
+            fib_shm_off_t y = table[d];
+            if (FIB_SHM_NODE(heap, x)->key > FIB_SHM_NODE(heap, y)->key) {
+                fib_shm_off_t temp = x;
+                x = y;
+                y = temp;
+            }
+            fib_shm_link(heap, y, x);
+            table[d] = FIB_SHM_NULL;
+            d++;
+        }
+        table[d] = x;
+        current = next;
+    }
+
+    // Rebuild root list and find new minimum
+    heap->min_node = FIB_SHM_NULL;
+    for (int i = 0; i < FIB_SHM_MAX_DEGREE; i++) {
+        if (table[i] == FIB_SHM_NULL) {
+            continue;
+        }
+        fib_shm_add_to_root_list(heap, table[i]);
+        if (FIB_SHM_NODE(heap, table[i])->key < FIB_SHM_NODE(heap, heap->min_node)->key) {
+            heap->min_node = table[i];
+        }
+    }
+}
+
+// Helper function: Cut operation
+static void fib_shm_cut(fib_shm_heap_t* heap, fib_shm_off_t x, fib_shm_off_t y) {
+    fib_shm_node_t* xn = FIB_SHM_NODE(heap, x);
+    fib_shm_node_t* yn = FIB_SHM_NODE(heap, y);
+
+    if (yn->child == x) {
+        yn->child = (xn->right == x) ? FIB_SHM_NULL : xn->right;
+    }
+    fib_shm_list_remove(heap, x);
+    yn->degree--;
+
+    fib_shm_add_to_root_list(heap, x);
+    xn->parent = FIB_SHM_NULL;
+    xn->marked = 0;
+}
+
+// Helper function: Cascading cut operation
+static void fib_shm_cascading_cut(fib_shm_heap_t* heap, fib_shm_off_t y) {
+    fib_shm_off_t z = FIB_SHM_NODE(heap, y)->parent;
+    while (z != FIB_SHM_NULL) {
+        fib_shm_node_t* yn = FIB_SHM_NODE(heap, y);
+        if (!yn->marked) {
+            yn->marked = 1;
+            return;
+        }
+        fib_shm_cut(heap, y, z);
+        y = z;
+        z = FIB_SHM_NODE(heap, y)->parent;
+    }
+}
+
+// Helper function: Unlink the minimum node; caller frees the slot
+static fib_shm_off_t fib_shm_extract_min_locked(fib_shm_heap_t* heap) {
+    fib_shm_off_t z = heap->min_node;
+    fib_shm_node_t* zn = FIB_SHM_NODE(heap, z);
+
+    // Add all children of min_node to root list
+    if (zn->child != FIB_SHM_NULL) {
+        fib_shm_off_t child = zn->child;
+        fib_shm_off_t first = child;
+        do {
+            fib_shm_off_t next_child = FIB_SHM_NODE(heap, child)->right;
+            FIB_SHM_NODE(heap, child)->parent = FIB_SHM_NULL;
+            fib_shm_add_to_root_list(heap, child);
+            child = next_child;
+        } while (child != first);
+        zn->child = FIB_SHM_NULL;
+    }
+
+    fib_shm_list_remove(heap, z);
+
+    if (zn->right == z) {
+        heap->min_node = FIB_SHM_NULL;
+    } else {
+        heap->min_node = zn->right;
+        fib_shm_consolidate(heap);
+    }
+
+    heap->node_count--;
+    return z;
+}
+
+// Insert a new node into the heap
+fib_heap_error_t fib_shm_heap_insert(fib_shm_heap_t* heap, int key, uint64_t value,
+                                     fib_shm_off_t* handle) {
+    if (!heap) {
+        return FIB_HEAP_ERROR_NULL_POINTER;
+    }
+    if (fib_shm_lock(heap) != 0) {
+        return FIB_HEAP_ERROR_HEAP_CORRUPTION;
+    }
+
+    fib_shm_off_t off = fib_shm_node_alloc(heap);
+    if (off == FIB_SHM_NULL) {
+        fib_shm_unlock(heap);
+        return FIB_HEAP_ERROR_OUT_OF_MEMORY;
+    }
+
+    fib_shm_node_t* node = FIB_SHM_NODE(heap, off);
+    uint32_t generation = node->generation;
+    memset(node, 0, sizeof(*node));
+    node->key = key;
+    node->value = value;
+    node->generation = generation;
+
+    // Only a fully initialized node may be seen as live by a rebuild
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    node->in_use = 1;
+
+    fib_shm_add_to_root_list(heap, off);
+    if (key < FIB_SHM_NODE(heap, heap->min_node)->key) {
+        heap->min_node = off;
+    }
+    heap->node_count++;
+
+    fib_shm_unlock(heap);
+    if (handle) {
+        *handle = off | ((uint64_t)(generation & FIB_SHM_GENERATION_MASK) << FIB_SHM_OFFSET_BITS);
+    }
+    return FIB_HEAP_SUCCESS;
+}
+
+// Peek at the minimum without removing it
+fib_heap_error_t fib_shm_heap_minimum(fib_shm_heap_t* heap, int* key, uint64_t* value) {
+    if (!heap) {
+        return FIB_HEAP_ERROR_NULL_POINTER;
+    }
+    if (fib_shm_lock(heap) != 0) {
+        return FIB_HEAP_ERROR_HEAP_CORRUPTION;
+    }
+
+    if (heap->min_node == FIB_SHM_NULL) {
+        fib_shm_unlock(heap);
+        return FIB_HEAP_ERROR_EMPTY_HEAP;
+    }
+
+    fib_shm_node_t* min = FIB_SHM_NODE(heap, heap->min_node);
+    if (key) *key = min->key;
+    if (value) *value = min->value;
+
+    fib_shm_unlock(heap);
+    return FIB_HEAP_SUCCESS;
+}
+
+// Extract minimum node, copying out its key and payload
+fib_heap_error_t fib_shm_heap_extract_min(fib_shm_heap_t* heap, int* key, uint64_t* value) {
+    if (!heap) {
+        return FIB_HEAP_ERROR_NULL_POINTER;
+    }
+    if (fib_shm_lock(heap) != 0) {
+        return FIB_HEAP_ERROR_HEAP_CORRUPTION;
+    }
+
+    if (heap->min_node == FIB_SHM_NULL) {
+        fib_shm_unlock(heap);
+        return FIB_HEAP_ERROR_EMPTY_HEAP;
+    }
+
+    fib_shm_off_t z = fib_shm_extract_min_locked(heap);
+    fib_shm_node_t* zn = FIB_SHM_NODE(heap, z);
+    if (key) *key = zn->key;
+    if (value) *value = zn->value;
+    fib_shm_node_free(heap, z);
+
+    fib_shm_unlock(heap);
+    return FIB_HEAP_SUCCESS;
+}
+
+// Decrease key operation
+fib_heap_error_t fib_shm_heap_decrease_key(fib_shm_heap_t* heap, fib_shm_off_t handle, int new_key) {
+    if (!heap) {
+        return FIB_HEAP_ERROR_NULL_POINTER;
+    }
+    if (fib_shm_lock(heap) != 0) {
+        return FIB_HEAP_ERROR_HEAP_CORRUPTION;
+    }
+
+    if (!fib_shm_valid_handle(heap, handle)) {
+        fib_shm_unlock(heap);
+        return FIB_HEAP_ERROR_INVALID_HANDLE;
+    }
+
+    fib_shm_off_t off = handle & FIB_SHM_OFFSET_MASK;
+    fib_shm_node_t* node = FIB_SHM_NODE(heap, off);
+    if (new_key > node->key) {
+        fib_shm_unlock(heap);
+        return FIB_HEAP_ERROR_INVALID_KEY;
+    }
+
+    node->key = new_key;
+    fib_shm_off_t y = node->parent;
+    if (y != FIB_SHM_NULL && new_key < FIB_SHM_NODE(heap, y)->key) {
+        fib_shm_cut(heap, off, y);
+        fib_shm_cascading_cut(heap, y);
+    }
+
+    if (new_key < FIB_SHM_NODE(heap, heap->min_node)->key) {
+        heap->min_node = off;
+    }
+
+    fib_shm_unlock(heap);
+    return FIB_HEAP_SUCCESS;
+}
+
+// Delete a node
+fib_heap_error_t fib_shm_heap_delete_node(fib_shm_heap_t* heap, fib_shm_off_t handle) {
+    if (!heap) {
+        return FIB_HEAP_ERROR_NULL_POINTER;
+    }
+    if (fib_shm_lock(heap) != 0) {
+        return FIB_HEAP_ERROR_HEAP_CORRUPTION;
+    }
+
+    if (!fib_shm_valid_handle(heap, handle)) {
+        fib_shm_unlock(heap);
+        return FIB_HEAP_ERROR_INVALID_HANDLE;
+    }
+
+    // Move the node to the root list and make it the minimum
+    fib_shm_off_t off = handle & FIB_SHM_OFFSET_MASK;
+    fib_shm_off_t y = FIB_SHM_NODE(heap, off)->parent;
+    if (y != FIB_SHM_NULL) {
+        fib_shm_cut(heap, off, y);
+        fib_shm_cascading_cut(heap, y);
+    }
+    heap->min_node = off;
+
+    fib_shm_node_free(heap, fib_shm_extract_min_locked(heap));
+
+    fib_shm_unlock(heap);
+    return FIB_HEAP_SUCCESS;
+}
+
+// Get heap size
+size_t fib_shm_heap_size(fib_shm_heap_t* heap) {
+    return heap ? (size_t)__atomic_load_n(&heap->node_count, __ATOMIC_RELAXED) : 0;
+}
+
+// Get the number of node slots in the region
+size_t fib_shm_heap_capacity(fib_shm_heap_t* heap) {
+    return heap ? (size_t)heap->slot_count : 0;
+}
+
+// Get the number of times the forest was rebuilt after a lock owner died
+size_t fib_shm_heap_owner_deaths(fib_shm_heap_t* heap) {
+    return heap ? (size_t)__atomic_load_n(&heap->owner_deaths, __ATOMIC_RELAXED) : 0;
+}
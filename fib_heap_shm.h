@@ -0,0 +1,53 @@
+#ifndef FIB_HEAP_SHM_H
+#define FIB_HEAP_SHM_H
+
+#include "fibonacci_heap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Shared-memory Fibonacci heap.
+//
+// The whole heap (header, node slots, lock) lives inside a caller-provided
+// memory region, typically obtained with shm_open()+mmap() or an anonymous
+// MAP_SHARED mapping inherited across fork(). Links are stored as byte
+// offsets from the start of the region, so every process may map the region
+// at a different address. All operations take a process-shared robust mutex.
+// If a process dies while holding it, the next process to lock it rebuilds
+// the forest from the node slots, since the dead process may have stopped
+// halfway through relinking nodes.
+
+// Offset of a node from the region base (0 is the null offset). Handles
+// returned by insert also carry the slot's generation in the bits above the
+// low 40, so a handle goes stale once its node leaves the heap, even if the
+// slot is reused (the generation wraps after 2^24 reuses of one slot).
+typedef uint64_t fib_shm_off_t;
+
+#define FIB_SHM_NULL ((fib_shm_off_t)0)
+
+typedef struct fib_shm_heap fib_shm_heap_t;
+
+// Region setup (regions are limited to 1 TiB)
+fib_shm_heap_t* fib_shm_heap_init(void* region, size_t region_size);
+fib_shm_heap_t* fib_shm_heap_attach(void* region);
+size_t fib_shm_heap_region_size(size_t max_nodes);
+
+// Basic operations (payloads are plain 64-bit values, not pointers)
+fib_heap_error_t fib_shm_heap_insert(fib_shm_heap_t* heap, int key, uint64_t value,
+                                     fib_shm_off_t* handle);
+fib_heap_error_t fib_shm_heap_minimum(fib_shm_heap_t* heap, int* key, uint64_t* value);
+fib_heap_error_t fib_shm_heap_extract_min(fib_shm_heap_t* heap, int* key, uint64_t* value);
+fib_heap_error_t fib_shm_heap_decrease_key(fib_shm_heap_t* heap, fib_shm_off_t handle, int new_key);
+fib_heap_error_t fib_shm_heap_delete_node(fib_shm_heap_t* heap, fib_shm_off_t handle);
+
+// Status inquiry
+size_t fib_shm_heap_size(fib_shm_heap_t* heap);
+size_t fib_shm_heap_capacity(fib_shm_heap_t* heap);
+size_t fib_shm_heap_owner_deaths(fib_shm_heap_t* heap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIB_HEAP_SHM_H
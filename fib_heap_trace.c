@@ -0,0 +1,226 @@
+#include "fib_heap_trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+struct fib_trace {
+    fib_trace_record_t* ring;
+    size_t capacity;
+    size_t head;                // Index of the oldest buffered record
+    size_t count;               // Buffered records
+    uint64_t total;             // Records ever appended
+    FILE* file;
+    bool write_failed;
+};
+
+// Helper function prototypes
+static void fib_trace_hook(const fib_heap_t* heap, fib_heap_op_t op, int key,
+                           const void* node, const void* other, void* user_ctx);
+
+// Create a recorder with room for ring_records buffered records
+fib_trace_t* fib_trace_create(size_t ring_records, const char* path) {
+    if (ring_records == 0) {
+        return NULL;
+    }
+
+    fib_trace_t* trace = (fib_trace_t*)calloc(1, sizeof(fib_trace_t));
+    if (!trace) {
+        return NULL;
+    }
+
+    trace->ring = (fib_trace_record_t*)malloc(ring_records * sizeof(fib_trace_record_t));
+    if (!trace->ring) {
+        free(trace);
+        return NULL;
+    }
+    trace->capacity = ring_records;
+
+    if (path) {
+        trace->file = fopen(path, "wb");
+        fib_trace_file_header_t header = {FIB_TRACE_MAGIC, FIB_TRACE_VERSION,
+                                          (uint32_t)sizeof(fib_trace_record_t)};
+        if (!trace->file || fwrite(&header, sizeof(header), 1, trace->file) != 1) {
+            if (trace->file) {
+                fclose(trace->file);
+            }
+            free(trace->ring);
+            free(trace);
+            return NULL;
+        }
+    }
+
+    return trace;
+}
+
+// Flush, close the file and free the recorder
+void fib_trace_destroy(fib_trace_t* trace) {
+    if (!trace) {
+        return;
+    }
+
+    if (trace->file) {
+        fib_trace_flush(trace);
+        fclose(trace->file);
+    }
+    free(trace->ring);
+    free(trace);
+}
+
+// Start recording a heap
+fib_heap_error_t fib_trace_attach(fib_trace_t* trace, fib_heap_t* heap) {
+    if (!trace || !heap) {
+        return FIB_HEAP_ERROR_NULL_POINTER;
+    }
+    return fib_heap_set_trace(heap, fib_trace_hook, trace);
+}
+
+// Stop recording a heap
+fib_heap_error_t fib_trace_detach(fib_trace_t* trace, fib_heap_t* heap) {
+    if (!trace || !heap) {
+        return FIB_HEAP_ERROR_NULL_POINTER;
+    }
+    if (heap->trace_ctx != trace) {
+        return FIB_HEAP_ERROR_INVALID_STATE;
+    }
+    return fib_heap_set_trace(heap, NULL, NULL);
+}
+
+// Write buffered records to the file and empty the ring
+fib_heap_error_t fib_trace_flush(fib_trace_t* trace) {
+    if (!trace) {
+        return FIB_HEAP_ERROR_NULL_POINTER;
+    }
+
+    if (!trace->file) {
+        return FIB_HEAP_SUCCESS;
+    }
+
+    // The buffered records wrap at most once around the end of the ring
+    size_t first = trace->count;
+    if (trace->head + first > trace->capacity) {
+        first = trace->capacity - trace->head;
+    }
+    size_t second = trace->count - first;
+
+    if (fwrite(trace->ring + trace->head, sizeof(fib_trace_record_t), first, trace->file) != first ||
+        fwrite(trace->ring, sizeof(fib_trace_record_t), second, trace->file) != second ||
+        fflush(trace->file) != 0) {
+        trace->write_failed = true;
+    }
+
+    trace->head = 0;
+    trace->count = 0;
+    return trace->write_failed ? FIB_HEAP_ERROR_INVALID_STATE : FIB_HEAP_SUCCESS;
+}
+
+// Copy out the buffered records, oldest first
+size_t fib_trace_snapshot(fib_trace_t* trace, fib_trace_record_t* out, size_t max) {
+    if (!trace || !out) {
+        return 0;
+    }
+
+    size_t n = trace->count < max ? trace->count : max;
+    size_t start = trace->count - n;        // Keep the most recent n
+    for (size_t i = 0; i < n; i++) {
+        out[i] = trace->ring[(trace->head + start + i) % trace->capacity];
+    }
+    return n;
+}
+
+// Get number of records appended since creation
+uint64_t fib_trace_total_records(fib_trace_t* trace) {
+    return trace ? trace->total : 0;
+}
+
+// Read a trace file written by a recorder
+fib_heap_error_t fib_trace_load(const char* path, fib_trace_record_t** records, size_t* count) {
+    if (!path || !records || !count) {
+        return FIB_HEAP_ERROR_NULL_POINTER;
+    }
+    *records = NULL;
+    *count = 0;
+
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return FIB_HEAP_ERROR_INVALID_HANDLE;
+    }
+
+    fib_trace_file_header_t header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != FIB_TRACE_MAGIC ||
+        header.version != FIB_TRACE_VERSION || header.record_size != sizeof(fib_trace_record_t)) {
+        fclose(file);
+        return FIB_HEAP_ERROR_HEAP_CORRUPTION;
+    }
+
+    size_t capacity = 1024;
+    fib_trace_record_t* buffer = (fib_trace_record_t*)malloc(capacity * sizeof(fib_trace_record_t));
+    size_t n = 0;
+    while (buffer) {
+        n += fread(buffer + n, sizeof(fib_trace_record_t), capacity - n, file);
+        if (n < capacity) {
+            break;
+        }
+        capacity *= 2;
+        fib_trace_record_t* grown = (fib_trace_record_t*)realloc(buffer, capacity * sizeof(fib_trace_record_t));
+        if (!grown) {
+            free(buffer);
+        }
+        buffer = grown;
+    }
+    fclose(file);
+
+    if (!buffer) {
+        return FIB_HEAP_ERROR_OUT_OF_MEMORY;
+    }
+    *records = buffer;
+    *count = n;
+    return FIB_HEAP_SUCCESS;
+}
+
+// Get an operation's short name
+const char* fib_trace_op_name(uint32_t op) {
+    switch (op) {
+        case FIB_HEAP_OP_INSERT:
+            return "insert";
+        case FIB_HEAP_OP_EXTRACT_MIN:
+            return "extract_min";
+        case FIB_HEAP_OP_DECREASE_KEY:
+            return "decrease_key";
+        case FIB_HEAP_OP_DELETE:
+            return "delete";
+        case FIB_HEAP_OP_UNION:
+            return "union";
+        case FIB_HEAP_OP_STEAL:
+            return "steal";
+        case FIB_HEAP_OP_RELOCATE:
+            return "relocate";
+        case FIB_HEAP_OP_DESTROY:
+            return "destroy";
+        default:
+            return "unknown";
+    }
+}
+
+// Helper function: fib_heap_trace_fn appending one record
+static void fib_trace_hook(const fib_heap_t* heap, fib_heap_op_t op, int key,
+                           const void* node, const void* other, void* user_ctx) {
+    fib_trace_t* trace = (fib_trace_t*)user_ctx;
+
+    if (trace->count == trace->capacity) {
+        if (trace->file) {
+            fib_trace_flush(trace);
+        } else {
+            // Flight recorder: overwrite the oldest record
+            trace->head = (trace->head + 1) % trace->capacity;
+            trace->count--;
+        }
+    }
+
+    fib_trace_record_t* record = &trace->ring[(trace->head + trace->count) % trace->capacity];
+    record->op = (uint32_t)op;
+    record->key = key;
+    record->heap = (uint64_t)(uintptr_t)heap;
+    record->node = (uint64_t)(uintptr_t)node;
+    record->other = (uint64_t)(uintptr_t)other;
+    trace->count++;
+    trace->total++;
+}
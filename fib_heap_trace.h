@@ -0,0 +1,67 @@
+#ifndef FIB_HEAP_TRACE_H
+#define FIB_HEAP_TRACE_H
+
+#include "fibonacci_heap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Operation trace recorder.
+//
+// A recorder attached to one or more heaps (through fib_heap_set_trace)
+// appends a fixed-size binary record for every operation to a ring buffer.
+// With a file, the ring is flushed to it whenever it fills and on destroy,
+// so the file holds the complete trace; without one, the ring keeps the
+// most recent records as a flight recorder. Heaps and nodes are identified
+// by their addresses at record time, which fibheap-replay maps back onto
+// the heaps and nodes it creates. A recorder is not thread-safe: heaps
+// sharing one must be mutated under a common lock.
+
+#define FIB_TRACE_MAGIC 0x3130435254424946ULL   // "FIBTRC01"
+#define FIB_TRACE_VERSION 1
+
+// One traced operation (fields as in fib_heap_trace_fn)
+typedef struct {
+    uint32_t op;                // fib_heap_op_t
+    int32_t key;
+    uint64_t heap;              // Heap the operation ran on
+    uint64_t node;              // Node touched, or 0
+    uint64_t other;             // Absorbed heap / steal victim / relocated node, or 0
+} fib_trace_record_t;
+
+// File header, followed by records until end of file
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t record_size;
+} fib_trace_file_header_t;
+
+typedef struct fib_trace fib_trace_t;
+
+// Recorder creation and destruction (path may be NULL for ring-only)
+fib_trace_t* fib_trace_create(size_t ring_records, const char* path);
+void fib_trace_destroy(fib_trace_t* trace);
+
+// Start or stop recording a heap's operations
+fib_heap_error_t fib_trace_attach(fib_trace_t* trace, fib_heap_t* heap);
+fib_heap_error_t fib_trace_detach(fib_trace_t* trace, fib_heap_t* heap);
+
+// Write buffered records to the file
+fib_heap_error_t fib_trace_flush(fib_trace_t* trace);
+
+// Copy out up to max of the buffered records, oldest first
+size_t fib_trace_snapshot(fib_trace_t* trace, fib_trace_record_t* out, size_t max);
+uint64_t fib_trace_total_records(fib_trace_t* trace);
+
+// Load a whole trace file; free *records with free()
+fib_heap_error_t fib_trace_load(const char* path, fib_trace_record_t** records, size_t* count);
+
+// Short name of an operation ("insert", "extract_min", ...)
+const char* fib_trace_op_name(uint32_t op);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIB_HEAP_TRACE_H
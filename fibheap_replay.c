@@ -0,0 +1,425 @@
+#define _GNU_SOURCE
+#include "fibonacci_heap.h"
+#include "fib_heap_trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// fibheap-replay: replay a recorded operation trace against a heap backend
+// and report per-operation latency.
+//
+// Usage: fibheap-replay [--backend NAME] TRACE
+//
+// Heap and node identities in the trace are mapped onto the heaps and
+// handles this run creates. When the backend breaks ties differently from
+// the recorded heap, extract-min returns a different element than it did in
+// production; such extracts are counted as divergent and later operations
+// on elements that are no longer present are skipped.
+
+#define REPLAY_OP_COUNT (FIB_HEAP_OP_DESTROY + 1)
+
+// Heap implementation under test; handles are opaque
+typedef struct {
+    const char* name;
+    const char* description;
+    void* (*create)(void);
+    void (*destroy)(void* heap);
+    void* (*insert)(void* heap, int key);
+    void* (*extract_min)(void* heap);           // Returns the released handle (identity only)
+    bool (*decrease_key)(void* heap, void* handle, int key);
+    bool (*remove)(void* heap, void* handle);
+    bool (*merge)(void* into, void* from);
+    bool (*steal)(void* thief, void* victim, size_t max_nodes);   // NULL if unsupported
+} replay_backend_t;
+
+// Open-addressing map from 64-bit identities to 64-bit values (0 is never a key)
+typedef struct {
+    uint64_t* keys;
+    uint64_t* values;
+    size_t capacity;            // Power of two
+    size_t count;
+} replay_map_t;
+
+// Latency samples for one operation type
+typedef struct {
+    uint64_t* samples;
+    size_t count;
+    size_t capacity;
+} replay_latency_t;
+
+// Backend: the library's Fibonacci heap
+static void* fib_backend_create(void) {
+    return fib_heap_create();
+}
+
+static void* fib_stable_backend_create(void) {
+    fib_heap_t* heap = fib_heap_create();
+    fib_heap_set_stable(heap, true);
+    return heap;
+}
+
+static void* fib_radix_backend_create(void) {
+    fib_heap_t* heap = fib_heap_create();
+    fib_heap_set_monotone(heap, true);
+    return heap;
+}
+
+static void fib_backend_destroy(void* heap) {
+    fib_heap_destroy((fib_heap_t*)heap);
+}
+
+static void* fib_backend_insert(void* heap, int key) {
+    return fib_heap_insert((fib_heap_t*)heap, key, NULL);
+}
+
+static void* fib_backend_extract_min(void* heap) {
+    fib_node_t* node = fib_heap_extract_min((fib_heap_t*)heap);
+    fib_heap_free_node((fib_heap_t*)heap, node);
+    return node;
+}
+
+static bool fib_backend_decrease_key(void* heap, void* handle, int key) {
+    return fib_heap_decrease_key((fib_heap_t*)heap, (fib_node_t*)handle, key) == FIB_HEAP_SUCCESS;
+}
+
+static bool fib_backend_remove(void* heap, void* handle) {
+    return fib_heap_delete_node((fib_heap_t*)heap, (fib_node_t*)handle) == FIB_HEAP_SUCCESS;
+}
+
+static bool fib_backend_merge(void* into, void* from) {
+    return fib_heap_union((fib_heap_t*)into, (fib_heap_t*)from) == FIB_HEAP_SUCCESS;
+}
+
+static bool fib_backend_steal(void* thief, void* victim, size_t max_nodes) {
+    return fib_heap_steal((fib_heap_t*)thief, (fib_heap_t*)victim, max_nodes, NULL) == FIB_HEAP_SUCCESS;
+}
+
+static const replay_backend_t backends[] = {
+    {"fib", "Fibonacci heap (fibonacci_heap.h)", fib_backend_create, fib_backend_destroy,
+     fib_backend_insert, fib_backend_extract_min, fib_backend_decrease_key, fib_backend_remove,
+     fib_backend_merge, fib_backend_steal},
+    {"fib-stable", "Fibonacci heap in stable (FIFO tie) mode", fib_stable_backend_create,
+     fib_backend_destroy, fib_backend_insert, fib_backend_extract_min, fib_backend_decrease_key,
+     fib_backend_remove, fib_backend_merge, fib_backend_steal},
+    {"fib-radix", "Fibonacci heap in monotone (radix bucket) mode", fib_radix_backend_create,
+     fib_backend_destroy, fib_backend_insert, fib_backend_extract_min, fib_backend_decrease_key,
+     fib_backend_remove, fib_backend_merge, NULL},
+};
+
+// Helper function: Hash an identity (addresses have low-entropy low bits)
+static size_t replay_hash(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (size_t)key;
+}
+
+static bool replay_map_init(replay_map_t* map, size_t capacity) {
+    map->keys = (uint64_t*)calloc(capacity, sizeof(uint64_t));
+    map->values = (uint64_t*)malloc(capacity * sizeof(uint64_t));
+    map->capacity = capacity;
+    map->count = 0;
+    return map->keys && map->values;
+}
+
+static void replay_map_free(replay_map_t* map) {
+    free(map->keys);
+    free(map->values);
+}
+
+static uint64_t replay_map_get(const replay_map_t* map, uint64_t key) {
+    for (size_t i = replay_hash(key) & (map->capacity - 1);; i = (i + 1) & (map->capacity - 1)) {
+        if (map->keys[i] == key) {
+            return map->values[i];
+        }
+        if (map->keys[i] == 0) {
+            return 0;
+        }
+    }
+}
+
+static bool replay_map_put(replay_map_t* map, uint64_t key, uint64_t value) {
+    if (2 * (map->count + 1) > map->capacity) {
+        replay_map_t grown;
+        if (!replay_map_init(&grown, map->capacity * 2)) {
+            replay_map_free(&grown);
+            return false;
+        }
+        for (size_t i = 0; i < map->capacity; i++) {
+            if (map->keys[i]) {
+                replay_map_put(&grown, map->keys[i], map->values[i]);
+            }
+        }
+        replay_map_free(map);
+        *map = grown;
+    }
+
+    size_t i = replay_hash(key) & (map->capacity - 1);
+    while (map->keys[i] && map->keys[i] != key) {
+        i = (i + 1) & (map->capacity - 1);
+    }
+    if (!map->keys[i]) {
+        map->keys[i] = key;
+        map->count++;
+    }
+    map->values[i] = value;
+    return true;
+}
+
+// Linear probing removal with backward shift, so lookups never need tombstones
+static void replay_map_remove(replay_map_t* map, uint64_t key) {
+    size_t mask = map->capacity - 1;
+    size_t i = replay_hash(key) & mask;
+    while (map->keys[i] != key) {
+        if (!map->keys[i]) {
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+
+    size_t hole = i;
+    for (size_t j = (hole + 1) & mask; map->keys[j]; j = (j + 1) & mask) {
+        size_t home = replay_hash(map->keys[j]) & mask;
+        // Move j into the hole unless its home lies cyclically in (hole, j]
+        bool stays = hole <= j ? (home > hole && home <= j) : (home > hole || home <= j);
+        if (!stays) {
+            map->keys[hole] = map->keys[j];
+            map->values[hole] = map->values[j];
+            hole = j;
+        }
+    }
+    map->keys[hole] = 0;
+    map->count--;
+}
+
+static void replay_latency_add(replay_latency_t* latency, uint64_t ns) {
+    if (latency->count == latency->capacity) {
+        size_t capacity = latency->capacity ? latency->capacity * 2 : 4096;
+        uint64_t* grown = (uint64_t*)realloc(latency->samples, capacity * sizeof(uint64_t));
+        if (!grown) {
+            return;
+        }
+        latency->samples = grown;
+        latency->capacity = capacity;
+    }
+    latency->samples[latency->count++] = ns;
+}
+
+static int replay_compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static uint64_t replay_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Helper function: Heap for a traced heap identity, created on first use
+static void* replay_heap(const replay_backend_t* backend, replay_map_t* heaps, uint64_t id) {
+    void* heap = (void*)(uintptr_t)replay_map_get(heaps, id);
+    if (!heap) {
+        heap = backend->create();
+        if (heap && !replay_map_put(heaps, id, (uint64_t)(uintptr_t)heap)) {
+            backend->destroy(heap);
+            heap = NULL;
+        }
+    }
+    return heap;
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [--backend NAME] TRACE\n\nBackends:\n", program);
+    for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); i++) {
+        fprintf(stderr, "  %-12s %s\n", backends[i].name, backends[i].description);
+    }
+}
+
+int main(int argc, char** argv) {
+    const replay_backend_t* backend = &backends[0];
+    const char* path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--backend") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            backend = NULL;
+            for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+                if (strcmp(backends[b].name, name) == 0) {
+                    backend = &backends[b];
+                }
+            }
+            if (!backend) {
+                fprintf(stderr, "Unknown backend: %s\n", name);
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (!path && argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!path) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    fib_trace_record_t* records = NULL;
+    size_t count = 0;
+    fib_heap_error_t result = fib_trace_load(path, &records, &count);
+    if (result != FIB_HEAP_SUCCESS) {
+        fprintf(stderr, "Cannot load trace %s: %s\n", path, fib_heap_error_string(result));
+        return 1;
+    }
+
+    // Traced node id -> handle, and handle -> traced node id for divergent extracts
+    replay_map_t heaps, nodes, owners;
+    if (!replay_map_init(&heaps, 64) || !replay_map_init(&nodes, 1024) || !replay_map_init(&owners, 1024)) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    replay_latency_t latency[REPLAY_OP_COUNT];
+    memset(latency, 0, sizeof(latency));
+    size_t skipped = 0;
+    size_t divergent = 0;
+    uint64_t replay_start = replay_now_ns();
+
+    for (size_t r = 0; r < count; r++) {
+        const fib_trace_record_t* record = &records[r];
+        if (record->op == 0 || record->op >= REPLAY_OP_COUNT) {
+            skipped++;
+            continue;
+        }
+
+        // Relocation only renames a handle, there is nothing to time
+        if (record->op == FIB_HEAP_OP_RELOCATE) {
+            uint64_t handle = replay_map_get(&nodes, record->node);
+            if (handle) {
+                replay_map_remove(&nodes, record->node);
+                replay_map_put(&nodes, record->other, handle);
+                replay_map_put(&owners, handle, record->other);
+            }
+            continue;
+        }
+
+        if (record->op == FIB_HEAP_OP_DESTROY) {
+            void* heap = (void*)(uintptr_t)replay_map_get(&heaps, record->heap);
+            if (heap) {
+                uint64_t start = replay_now_ns();
+                backend->destroy(heap);
+                replay_latency_add(&latency[record->op], replay_now_ns() - start);
+                replay_map_remove(&heaps, record->heap);
+            }
+            continue;
+        }
+
+        void* heap = replay_heap(backend, &heaps, record->heap);
+        uint64_t handle = record->node ? replay_map_get(&nodes, record->node) : 0;
+        if (!heap || (record->node && record->op != FIB_HEAP_OP_INSERT &&
+                      record->op != FIB_HEAP_OP_EXTRACT_MIN && !handle)) {
+            skipped++;
+            continue;
+        }
+
+        uint64_t start = replay_now_ns();
+        bool ok = true;
+        void* produced = NULL;
+        switch (record->op) {
+            case FIB_HEAP_OP_INSERT:
+                produced = backend->insert(heap, record->key);
+                ok = produced != NULL;
+                break;
+            case FIB_HEAP_OP_EXTRACT_MIN:
+                produced = backend->extract_min(heap);
+                ok = produced != NULL;
+                break;
+            case FIB_HEAP_OP_DECREASE_KEY:
+                ok = backend->decrease_key(heap, (void*)(uintptr_t)handle, record->key);
+                break;
+            case FIB_HEAP_OP_DELETE:
+                ok = backend->remove(heap, (void*)(uintptr_t)handle);
+                break;
+            case FIB_HEAP_OP_UNION:
+            case FIB_HEAP_OP_STEAL: {
+                void* other = replay_heap(backend, &heaps, record->other);
+                if (!other || (record->op == FIB_HEAP_OP_STEAL && !backend->steal)) {
+                    ok = false;
+                } else if (record->op == FIB_HEAP_OP_UNION) {
+                    ok = backend->merge(heap, other);
+                } else {
+                    ok = backend->steal(heap, other, (size_t)record->key);
+                }
+                break;
+            }
+        }
+        uint64_t elapsed = replay_now_ns() - start;
+
+        if (!ok && record->op == FIB_HEAP_OP_UNION) {
+            // Later records would address the absorbed nodes through the wrong heap
+            fprintf(stderr, "Backend '%s' rejected the union at record %zu; stopping there\n",
+                    backend->name, r);
+            skipped += count - r;
+            break;
+        }
+        if (!ok) {
+            skipped++;
+            continue;
+        }
+        replay_latency_add(&latency[record->op], elapsed);
+
+        // Keep the identity maps in step with what the backend did
+        if (record->op == FIB_HEAP_OP_INSERT) {
+            replay_map_put(&nodes, record->node, (uint64_t)(uintptr_t)produced);
+            replay_map_put(&owners, (uint64_t)(uintptr_t)produced, record->node);
+        } else if (record->op == FIB_HEAP_OP_EXTRACT_MIN || record->op == FIB_HEAP_OP_DELETE) {
+            uint64_t released = record->op == FIB_HEAP_OP_DELETE ? handle : (uint64_t)(uintptr_t)produced;
+            uint64_t owner = replay_map_get(&owners, released);
+            if (owner != record->node) {
+                divergent++;
+            }
+            replay_map_remove(&owners, released);
+            if (owner) {
+                replay_map_remove(&nodes, owner);
+            }
+        }
+    }
+
+    double total_ms = (replay_now_ns() - replay_start) / 1e6;
+
+    printf("Replayed %s: %zu records on backend '%s' in %.1f ms (%zu skipped, %zu divergent extracts)\n",
+           path, count, backend->name, total_ms, skipped, divergent);
+    printf("%-14s %12s %10s %10s %10s %10s\n", "operation", "count", "mean ns", "p50 ns", "p99 ns", "max ns");
+    for (int op = 1; op < REPLAY_OP_COUNT; op++) {
+        replay_latency_t* l = &latency[op];
+        if (l->count == 0) {
+            continue;
+        }
+        qsort(l->samples, l->count, sizeof(uint64_t), replay_compare_u64);
+        double sum = 0;
+        for (size_t i = 0; i < l->count; i++) {
+            sum += (double)l->samples[i];
+        }
+        printf("%-14s %12zu %10.1f %10llu %10llu %10llu\n", fib_trace_op_name(op), l->count,
+               sum / l->count, (unsigned long long)l->samples[l->count / 2],
+               (unsigned long long)l->samples[(size_t)(l->count * 0.99)],
+               (unsigned long long)l->samples[l->count - 1]);
+        free(l->samples);
+    }
+
+    // Heaps still alive at the end of the trace
+    for (size_t i = 0; i < heaps.capacity; i++) {
+        if (heaps.keys[i]) {
+            backend->destroy((void*)(uintptr_t)heaps.values[i]);
+        }
+    }
+    replay_map_free(&heaps);
+    replay_map_free(&nodes);
+    replay_map_free(&owners);
+    free(records);
+    return 0;
+}
@@ -12,6 +12,7 @@ extern "C" {
 // Forward declarations
 typedef struct fib_node fib_node_t;
 typedef struct fib_heap fib_heap_t;
+typedef struct fib_node_block fib_node_block_t;
 
 // Error codes
 typedef enum {
@@ -21,13 +22,52 @@ typedef enum {
     FIB_HEAP_ERROR_OUT_OF_MEMORY,
     FIB_HEAP_ERROR_EMPTY_HEAP,
     FIB_HEAP_ERROR_INVALID_KEY,
-    FIB_HEAP_ERROR_HEAP_CORRUPTION
+    FIB_HEAP_ERROR_HEAP_CORRUPTION,
+    FIB_HEAP_ERROR_INVALID_STATE
 } fib_heap_error_t;
 
+// Operations reported to a trace hook
+typedef enum {
+    FIB_HEAP_OP_INSERT = 1,
+    FIB_HEAP_OP_EXTRACT_MIN,
+    FIB_HEAP_OP_DECREASE_KEY,   // Also reported once per node by fib_heap_decrease_key_batch
+    FIB_HEAP_OP_DELETE,
+    FIB_HEAP_OP_UNION,
+    FIB_HEAP_OP_STEAL,          // key is max_nodes, clamped to INT_MAX
+    FIB_HEAP_OP_RELOCATE,       // A node moved by fib_heap_compact
+    FIB_HEAP_OP_DESTROY
+} fib_heap_op_t;
+
+// Called after each operation on a traced heap (before it, for delete and
+// destroy). node is the node the operation touched; other is the absorbed
+// heap for union, the victim for steal and the new node for relocate.
+typedef void (*fib_heap_trace_fn)(const fib_heap_t* heap, fib_heap_op_t op, int key,
+                                  const void* node, const void* other, void* user_ctx);
+
+// Memory source for a heap's own allocations (the heap itself, nodes and
+// work buffers). free receives the size passed to the matching alloc.
+// alloc_aligned is optional and serves fib_heap_compact's node blocks,
+// which must be aligned to their size; they go back through free. Without
+// it the heap cannot be compacted. free_batch is optional too: a sorted
+// drain hands it every node at once (all of the given size), and falls back
+// to one free per node without it. page_usage, also optional, reports the
+// bytes the allocator holds and how many of them it placed on huge pages
+// for fib_heap_get_statistics; it is called on every query, so it must be
+// cheap.
+typedef struct {
+    void* (*alloc)(void* user_ctx, size_t size);
+    void (*free)(void* user_ctx, void* ptr, size_t size);
+    void* user_ctx;
+    void* (*alloc_aligned)(void* user_ctx, size_t alignment, size_t size);
+    void (*free_batch)(void* user_ctx, void* const ptrs[], size_t count, size_t size);
+    void (*page_usage)(void* user_ctx, size_t* bytes, size_t* huge_bytes);
+} fib_heap_allocator_t;
+
 // Node structure
 struct fib_node {
     int key;                    // Node's key value
     void* data;                 // User data pointer
+    uint64_t seq;               // Insertion sequence (tie-breaker in stable mode)
 
     struct fib_node* parent;    // Parent node
     struct fib_node* child;     // One of the child nodes
@@ -36,14 +76,65 @@ struct fib_node {
 
     int degree;                 // Number of children
     bool marked;                // Mark for cascading cut
+    bool pooled;                // Lives in a heap-owned node block (see fib_heap_compact)
+    bool dead;                  // Cancelled (see fib_heap_cancel)
+    uint32_t compact_epoch;     // Last compaction pass that relocated this node
+    uint32_t dead_slot;         // Position in the heap's dead list while dead
 };
 
 // Heap structure
 struct fib_heap {
-    fib_node_t* min_node;       // Pointer to minimum node
+    fib_node_t* min_node;       // Pointer to minimum node (monotone mode: NULL until located)
     size_t node_count;          // Total number of nodes
+    uint64_t next_seq;          // Next node sequence (union and steal renumber absorbed nodes above it)
+    bool stable;                // Break key ties by insertion order (FIFO)
+
+    fib_node_t** root_scratch;  // Consolidate work buffer, reused across calls
+    size_t root_scratch_capacity;
+
+    uint32_t compact_epoch;     // Current compaction pass
+    fib_node_t* compact_cursor; // Where an unfinished pass resumes
+    fib_node_block_t* node_block; // Block compaction is currently filling
+
+    bool concurrent;            // Publish the minimum for readers without the lock
+    uint32_t min_seqlock;       // Odd while the published minimum is being rewritten
+    int published_key;          // Published minimum (atomic, under min_seqlock)
+    fib_node_t* published_node;
+    size_t published_size;      // Published node count (atomic)
+
+    fib_heap_trace_fn trace;    // Operation hook (see fib_heap_set_trace)
+    void* trace_ctx;
+
+    bool monotone;              // Radix storage for monotone integer keys
+    int radix_last;             // Last extracted key; no smaller key is accepted
+    uint64_t radix_occupied;    // Bit b set when radix_buckets[b] is non-empty
+    fib_node_t** radix_buckets; // Bucket b holds keys whose highest bit differing from radix_last is b-1
+    size_t monotone_violations; // Inserts rejected for keys below radix_last
+
+    fib_node_t** dead_nodes;    // Cancelled nodes still in the forest (counted in node_count)
+    size_t dead_count;
+    size_t dead_capacity;
+    size_t purge_threshold;     // Purge automatically at this many dead nodes (0 = never)
+
+    fib_heap_allocator_t allocator; // Source of nodes and buffers (see fib_heap_create_with_allocator)
 };
 
+// Minimum as seen by fib_heap_peek_min. The node is an identity only: it may
+// already have been extracted by the time the caller looks at it. A monotone
+// heap locates its minimum lazily after an extraction; until its owner next
+// needs it, the snapshot has no node and key is a lower bound on all keys.
+typedef struct {
+    int key;
+    fib_node_t* node;
+    bool valid;                 // False when the heap was empty or the minimum not yet located
+} fib_heap_min_snapshot_t;
+
+// Receives the elements of a sorted drain, smallest key first
+typedef void (*fib_heap_drain_fn)(int key, void* data, void* user_ctx);
+
+// Called for every node moved by fib_heap_compact, before old_node is released
+typedef void (*fib_heap_relocate_fn)(fib_node_t* old_node, fib_node_t* new_node, void* user_ctx);
+
 // Statistics structure
 typedef struct {
     size_t total_nodes;
@@ -52,26 +143,67 @@ typedef struct {
     int max_degree;
     int tree_count;
     double average_degree;
+    size_t monotone_violations;
+    size_t dead_nodes;          // Cancelled nodes awaiting purge (not in total_nodes)
+    size_t memory_bytes;        // Held by the heap's allocator (0 if it does not report)
+    size_t huge_page_bytes;     // Part of memory_bytes placed on huge pages
+    double huge_page_coverage;  // huge_page_bytes / memory_bytes
 } fib_heap_statistics_t;
 
 // Function prototypes
 
 // Heap creation and destruction
 fib_heap_t* fib_heap_create(void);
+fib_heap_t* fib_heap_create_with_allocator(const fib_heap_allocator_t* allocator);
 void fib_heap_destroy(fib_heap_t* heap);
 
+// Heap modes (stable and monotone only change while the heap is empty)
+fib_heap_error_t fib_heap_set_stable(fib_heap_t* heap, bool stable);
+fib_heap_error_t fib_heap_set_concurrent(fib_heap_t* heap, bool concurrent);
+// In monotone mode fib_heap_insert returns NULL both for a key below the
+// last extracted one and for an allocation failure. Either call
+// fib_heap_insert_checked, which returns FIB_HEAP_ERROR_INVALID_KEY or
+// FIB_HEAP_ERROR_OUT_OF_MEMORY, or check whether monotone_violations in
+// fib_heap_get_statistics went up after a NULL.
+fib_heap_error_t fib_heap_set_monotone(fib_heap_t* heap, bool monotone);
+fib_heap_error_t fib_heap_set_trace(fib_heap_t* heap, fib_heap_trace_fn trace, void* user_ctx);
+
 // Basic operations
 fib_node_t* fib_heap_insert(fib_heap_t* heap, int key, void* data);
+fib_heap_error_t fib_heap_insert_checked(fib_heap_t* heap, int key, void* data, fib_node_t** out_node);
+fib_heap_error_t fib_heap_insert_batch(fib_heap_t* heap, const int keys[], void* const data[],
+                                       size_t count, fib_node_t* out_nodes[]);
 fib_node_t* fib_heap_minimum(fib_heap_t* heap);
 fib_node_t* fib_heap_extract_min(fib_heap_t* heap);
 fib_heap_error_t fib_heap_decrease_key(fib_heap_t* heap, fib_node_t* node, int new_key);
+fib_heap_error_t fib_heap_decrease_key_batch(fib_heap_t* heap, fib_node_t* const nodes[],
+                                             const int new_keys[], size_t count);
 fib_heap_error_t fib_heap_delete_node(fib_heap_t* heap, fib_node_t* node);
+fib_heap_error_t fib_heap_cancel(fib_heap_t* heap, fib_node_t* node);
 fib_heap_error_t fib_heap_union(fib_heap_t* heap1, fib_heap_t* heap2);
+fib_heap_error_t fib_heap_steal(fib_heap_t* thief, fib_heap_t* victim, size_t max_nodes,
+                                size_t* stolen);
+void fib_heap_free_node(fib_heap_t* heap, fib_node_t* node);
+
+// Empty the heap in key order without per-element extract-min; nodes are
+// released in one batch at the end (a temporary buffer of 2 records per
+// element is used)
+fib_heap_error_t fib_heap_drain_sorted(fib_heap_t* heap, int* out_keys, void** out_data);
+fib_heap_error_t fib_heap_drain_sorted_fn(fib_heap_t* heap, fib_heap_drain_fn fn, void* user_ctx);
+
+// Maintenance
+fib_heap_error_t fib_heap_purge(fib_heap_t* heap);
+fib_heap_error_t fib_heap_set_purge_threshold(fib_heap_t* heap, size_t dead_nodes);
+fib_heap_error_t fib_heap_compact(fib_heap_t* heap, size_t budget,
+                                  fib_heap_relocate_fn relocate, void* user_ctx, bool* done);
 
 // Status inquiry
 bool fib_heap_empty(fib_heap_t* heap);
 size_t fib_heap_size(fib_heap_t* heap);
 
+// Lock-free status inquiry, safe against one mutator in concurrent mode
+fib_heap_min_snapshot_t fib_heap_peek_min(fib_heap_t* heap);
+
 // Utility functions
 fib_heap_error_t fib_heap_validate(fib_heap_t* heap);
 const char* fib_heap_error_string(fib_heap_error_t error);
@@ -0,0 +1,408 @@
+#ifndef FIBONACCI_HEAP_HPP
+#define FIBONACCI_HEAP_HPP
+
+// Header-only C++17 Fibonacci heap.
+//
+// Values are stored inline in the nodes (no separate allocation or void*
+// indirection per element), move-only types are supported, and nodes come
+// from a rebound copy of the user's allocator. Handles returned by push and
+// emplace stay valid until their element leaves the heap.
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fib {
+
+template <class T, class Compare = std::less<T>, class Allocator = std::allocator<T>>
+class FibonacciHeap {
+    struct Node {
+        Node* parent = nullptr;     // Parent node
+        Node* child = nullptr;      // One of the child nodes
+        Node* left = this;          // Left sibling
+        Node* right = this;         // Right sibling
+        int degree = 0;             // Number of children
+        bool marked = false;        // Mark for cascading cut
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T& value() noexcept { return *std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    using node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using node_traits = std::allocator_traits<node_allocator>;
+
+    // Degrees are bounded by log_phi(n) < 93 for any 64-bit size
+    static constexpr std::size_t max_degree = 96;
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using value_compare = Compare;
+    using allocator_type = Allocator;
+
+    // Stable reference to an element, valid until it is popped or erased
+    class handle {
+    public:
+        handle() noexcept = default;
+
+        const T& operator*() const noexcept { return node_->value(); }
+        const T* operator->() const noexcept { return &node_->value(); }
+        explicit operator bool() const noexcept { return node_ != nullptr; }
+        bool operator==(const handle& other) const noexcept { return node_ == other.node_; }
+        bool operator!=(const handle& other) const noexcept { return node_ != other.node_; }
+
+    private:
+        friend class FibonacciHeap;
+        explicit handle(Node* node) noexcept : node_(node) {}
+        Node* node_ = nullptr;
+    };
+
+    // Construction and destruction
+    FibonacciHeap() = default;
+    explicit FibonacciHeap(const Compare& compare, const Allocator& alloc = Allocator())
+        : compare_(compare), alloc_(alloc) {}
+    explicit FibonacciHeap(const Allocator& alloc) : alloc_(alloc) {}
+
+    FibonacciHeap(const FibonacciHeap&) = delete;
+    FibonacciHeap& operator=(const FibonacciHeap&) = delete;
+
+    FibonacciHeap(FibonacciHeap&& other) noexcept
+        : compare_(std::move(other.compare_)), alloc_(std::move(other.alloc_)),
+          min_(std::exchange(other.min_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+    // Nodes are taken over when the allocator propagates or compares equal;
+    // otherwise each element is moved into a node from this heap's allocator,
+    // which may throw, and other's handles do not carry over.
+    FibonacciHeap& operator=(FibonacciHeap&& other) noexcept(
+        (node_traits::propagate_on_container_move_assignment::value ||
+         node_traits::is_always_equal::value) &&
+        std::is_nothrow_move_assignable_v<Compare>) {
+        if (this != &other) {
+            clear();
+            compare_ = std::move(other.compare_);
+            if constexpr (node_traits::propagate_on_container_move_assignment::value) {
+                alloc_ = std::move(other.alloc_);
+            } else if (!(alloc_ == other.alloc_)) {
+                move_elements(other.min_);
+                other.clear();
+                return *this;
+            }
+            min_ = std::exchange(other.min_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+        }
+        return *this;
+    }
+
+    ~FibonacciHeap() { clear(); }
+
+    // Basic operations
+    handle push(const T& value) { return emplace(value); }
+    handle push(T&& value) { return emplace(std::move(value)); }
+
+    template <class... Args>
+    handle emplace(Args&&... args) {
+        Node* node = create_node(std::forward<Args>(args)...);
+        add_to_root_list(node);
+        if (less(node, min_)) {
+            min_ = node;
+        }
+        ++size_;
+        return handle(node);
+    }
+
+    const T& top() const {
+        if (!min_) {
+            throw std::out_of_range("FibonacciHeap::top on empty heap");
+        }
+        return min_->value();
+    }
+
+    handle top_handle() const noexcept { return handle(min_); }
+
+    // Remove the minimum and move its value out
+    T extract_min() {
+        if (!min_) {
+            throw std::out_of_range("FibonacciHeap::extract_min on empty heap");
+        }
+        Node* node = unlink_min();
+        T value(std::move(node->value()));
+        destroy_node(node);
+        return value;
+    }
+
+    void pop() {
+        if (!min_) {
+            throw std::out_of_range("FibonacciHeap::pop on empty heap");
+        }
+        destroy_node(unlink_min());
+    }
+
+    // Replace an element's value with one that does not compare greater
+    void decrease_key(handle h, const T& value) { decrease_key(h, T(value)); }
+
+    void decrease_key(handle h, T&& value) {
+        Node* node = checked(h);
+        if (compare_(node->value(), value)) {
+            throw std::invalid_argument("FibonacciHeap::decrease_key with a greater value");
+        }
+        node->value() = std::move(value);
+
+        Node* parent = node->parent;
+        if (parent && less(node, parent)) {
+            cut(node, parent);
+            cascading_cut(parent);
+        }
+        if (less(node, min_)) {
+            min_ = node;
+        }
+    }
+
+    // Remove an arbitrary element
+    void erase(handle h) {
+        Node* node = checked(h);
+        roots_.reserve(size_);
+        Node* parent = node->parent;
+        if (parent) {
+            cut(node, parent);
+            cascading_cut(parent);
+        }
+        min_ = node;
+        destroy_node(unlink_min());
+    }
+
+    // Move all elements of other into this heap; handles stay valid
+    void merge(FibonacciHeap& other) {
+        if (this == &other || !other.min_) {
+            return;
+        }
+        if (!(alloc_ == other.alloc_)) {
+            throw std::invalid_argument("FibonacciHeap::merge with unequal allocators");
+        }
+
+        if (!min_) {
+            min_ = other.min_;
+        } else {
+            Node* last = min_->left;
+            Node* other_last = other.min_->left;
+            last->right = other.min_;
+            other.min_->left = last;
+            other_last->right = min_;
+            min_->left = other_last;
+            if (less(other.min_, min_)) {
+                min_ = other.min_;
+            }
+        }
+
+        size_ += other.size_;
+        other.min_ = nullptr;
+        other.size_ = 0;
+    }
+
+    void clear() noexcept {
+        if (min_) {
+            destroy_list(min_);
+            min_ = nullptr;
+        }
+        size_ = 0;
+    }
+
+    // Status inquiry
+    bool empty() const noexcept { return size_ == 0; }
+    size_type size() const noexcept { return size_; }
+    value_compare value_comp() const { return compare_; }
+    allocator_type get_allocator() const { return allocator_type(alloc_); }
+
+private:
+    bool less(const Node* a, const Node* b) const {
+        return !b || compare_(const_cast<Node*>(a)->value(), const_cast<Node*>(b)->value());
+    }
+
+    Node* checked(handle h) const {
+        if (!h.node_) {
+            throw std::invalid_argument("FibonacciHeap: null handle");
+        }
+        return h.node_;
+    }
+
+    template <class... Args>
+    Node* create_node(Args&&... args) {
+        Node* node = node_traits::allocate(alloc_, 1);
+        ::new (static_cast<void*>(node)) Node();
+        try {
+            ::new (static_cast<void*>(node->storage)) T(std::forward<Args>(args)...);
+        } catch (...) {
+            node->~Node();
+            node_traits::deallocate(alloc_, node, 1);
+            throw;
+        }
+        return node;
+    }
+
+    void destroy_node(Node* node) noexcept {
+        node->value().~T();
+        node->~Node();
+        node_traits::deallocate(alloc_, node, 1);
+    }
+
+    // Move the values of a forest into new nodes of this heap
+    void move_elements(Node* first) {
+        if (!first) {
+            return;
+        }
+        Node* node = first;
+        do {
+            emplace(std::move(node->value()));
+            move_elements(node->child);
+            node = node->right;
+        } while (node != first);
+    }
+
+    void destroy_list(Node* first) noexcept {
+        Node* node = first;
+        do {
+            Node* next = node->right;
+            if (node->child) {
+                destroy_list(node->child);
+            }
+            destroy_node(node);
+            node = next;
+        } while (node != first);
+    }
+
+    void add_to_root_list(Node* node) noexcept {
+        if (!min_) {
+            node->left = node->right = node;
+            min_ = node;
+        } else {
+            node->right = min_->right;
+            node->left = min_;
+            min_->right->left = node;
+            min_->right = node;
+        }
+    }
+
+    static void remove_from_list(Node* node) noexcept {
+        node->left->right = node->right;
+        node->right->left = node->left;
+    }
+
+    static void link(Node* child, Node* parent) noexcept {
+        remove_from_list(child);
+        child->parent = parent;
+        if (!parent->child) {
+            parent->child = child;
+            child->left = child->right = child;
+        } else {
+            child->right = parent->child->right;
+            child->left = parent->child;
+            parent->child->right->left = child;
+            parent->child->right = child;
+        }
+        parent->degree++;
+        child->marked = false;
+    }
+
+    // Detach the minimum from the forest and consolidate; caller destroys it
+    Node* unlink_min() {
+        // Every node may become a root, so the snapshot buffer is sized before
+        // the forest is touched: consolidate cannot then fail halfway
+        roots_.reserve(size_);
+
+        Node* z = min_;
+        if (z->child) {
+            Node* child = z->child;
+            do {
+                Node* next = child->right;
+                child->parent = nullptr;
+                add_to_root_list(child);
+                child = next;
+            } while (child != z->child);
+            z->child = nullptr;
+        }
+
+        remove_from_list(z);
+        if (z->right == z) {
+            min_ = nullptr;
+        } else {
+            min_ = z->right;
+            consolidate();
+        }
+        --size_;
+        return z;
+    }
+
+    void consolidate() {
+        std::array<Node*, max_degree> table{};
+
+        // Snapshot the root list once; linking rewires it while we iterate.
+        // unlink_min reserved room for every node, so push_back cannot throw.
+        roots_.clear();
+        Node* current = min_;
+        do {
+            roots_.push_back(current);
+            current = current->right;
+        } while (current != min_);
+
+        for (Node* x : roots_) {
+            int d = x->degree;
+            while (table[d]) {
+                Node* y = table[d];
+                if (less(y, x)) {
+                    std::swap(x, y);
+                }
+                link(y, x);
+                table[d] = nullptr;
+                ++d;
+            }
+            table[d] = x;
+        }
+
+        min_ = nullptr;
+        for (Node* root : table) {
+            if (root) {
+                add_to_root_list(root);
+                if (less(root, min_)) {
+                    min_ = root;
+                }
+            }
+        }
+    }
+
+    void cut(Node* x, Node* y) noexcept {
+        if (y->child == x) {
+            y->child = (x->right == x) ? nullptr : x->right;
+        }
+        remove_from_list(x);
+        y->degree--;
+        add_to_root_list(x);
+        x->parent = nullptr;
+        x->marked = false;
+    }
+
+    void cascading_cut(Node* y) noexcept {
+        for (Node* z = y->parent; z; z = y->parent) {
+            if (!y->marked) {
+                y->marked = true;
+                return;
+            }
+            cut(y, z);
+            y = z;
+        }
+    }
+
+    Compare compare_{};
+    node_allocator alloc_{};
+    Node* min_ = nullptr;
+    size_type size_ = 0;
+    std::vector<Node*> roots_;      // Consolidate work buffer, reused across calls
+};
+
+} // namespace fib
+
+#endif // FIBONACCI_HEAP_HPP
@@ -1,8 +1,26 @@
+#define _GNU_SOURCE
 #include "fibonacci_heap.h"
+#include "fib_heap_shm.h"
+#include "fib_heap_bounded.h"
+#include "fib_heap_event_loop.h"
+#include "fib_heap_sched.h"
+#include "fib_heap_trace.h"
+#include "fib_heap_arena.h"
+#include "fib_heap_extmem.h"
+#include "fib_heap_bucket.h"
+#include "fib_heap_mpsc.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
 #include <time.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 // Test result tracking
 static int tests_run = 0;
@@ -187,6 +205,45 @@ void test_union() {
     printf("\n");
 }
 
+// Test moving the best root trees between heaps
+void test_steal() {
+    printf("=== Testing Root Stealing ===\n");
+
+    fib_heap_t* victim = fib_heap_create();
+    fib_heap_t* thief = fib_heap_create();
+
+    for (int i = 0; i < 100; i++) {
+        fib_heap_insert(victim, 100 - i, NULL);
+    }
+    fib_heap_free_node(victim, fib_heap_extract_min(victim));   // Consolidate into trees
+    fib_heap_insert(thief, 50, NULL);
+
+    size_t stolen = 0;
+    fib_heap_error_t result = fib_heap_steal(thief, victim, 30, &stolen);
+    TEST_ASSERT(result == FIB_HEAP_SUCCESS, "Steal succeeds");
+    TEST_ASSERT(stolen >= 30 || fib_heap_size(victim) == 0, "Steal moves at least the requested nodes");
+    TEST_ASSERT(fib_heap_size(victim) + fib_heap_size(thief) == 100, "Steal preserves node count");
+    TEST_ASSERT(fib_heap_size(thief) == stolen + 1, "Thief size includes stolen nodes");
+    TEST_ASSERT(fib_node_get_key(fib_heap_minimum(thief)) == 2, "Thief receives victim's minimum");
+    TEST_ASSERT(fib_heap_validate(victim) == FIB_HEAP_SUCCESS &&
+                fib_heap_validate(thief) == FIB_HEAP_SUCCESS, "Both heaps valid after steal");
+
+    // Every remaining victim key must still come out in order
+    int previous = INT_MIN;
+    bool ordered = true;
+    fib_node_t* node;
+    while ((node = fib_heap_extract_min(victim)) != NULL) {
+        ordered = ordered && node->key >= previous;
+        previous = node->key;
+        fib_heap_free_node(victim, node);
+    }
+    TEST_ASSERT(ordered, "Victim remains heap-ordered");
+
+    fib_heap_destroy(victim);
+    fib_heap_destroy(thief);
+    printf("\n");
+}
+
 // Test with user data
 void test_user_data() {
     printf("=== Testing User Data ===\n");
@@ -276,6 +333,1533 @@ void test_performance() {
     printf("\n");
 }
 
+// Test stable (FIFO) tie-breaking mode
+void test_stable_mode() {
+    printf("=== Testing Stable Mode ===\n");
+
+    fib_heap_t* heap = fib_heap_create();
+    TEST_ASSERT(fib_heap_set_stable(heap, true) == FIB_HEAP_SUCCESS, "Enable stable mode on empty heap");
+
+    int ids[64];
+    fib_node_t* nodes[64];
+    for (int i = 0; i < 64; i++) {
+        ids[i] = i;
+        nodes[i] = fib_heap_insert(heap, i % 4, &ids[i]);
+    }
+    TEST_ASSERT(fib_heap_set_stable(heap, false) == FIB_HEAP_ERROR_INVALID_STATE,
+                "Mode cannot change on non-empty heap");
+
+    // Consolidate once, then pull a late node down to an existing key
+    free(fib_heap_extract_min(heap));
+    fib_heap_decrease_key(heap, nodes[63], 1);
+
+    // Remaining order: key 0 ids 4,8,..60; then key 1 ids 1,5,..61 and 63 last
+    bool fifo = true;
+    int last_key = -1;
+    int last_id = -1;
+    while (!fib_heap_empty(heap)) {
+        fib_node_t* node = fib_heap_extract_min(heap);
+        int id = *(int*)node->data;
+        if (node->key == last_key && id < last_id) {
+            fifo = false;
+        }
+        if (node->key < last_key) {
+            fifo = false;
+        }
+        last_key = node->key;
+        last_id = id;
+        free(node);
+    }
+    TEST_ASSERT(fifo, "Equal keys are extracted in insertion order");
+
+    // Two stable heaps filled alternately with one key, then melded
+    fib_heap_t* other = fib_heap_create();
+    fib_heap_set_stable(other, true);
+    for (int i = 0; i < 64; i++) {
+        fib_heap_insert(i % 2 ? other : heap, 7, &ids[i]);
+    }
+    free(fib_heap_extract_min(other));
+    free(fib_heap_extract_min(heap));
+
+    fib_heap_t* plain = fib_heap_create();
+    TEST_ASSERT(fib_heap_union(heap, plain) == FIB_HEAP_ERROR_INVALID_STATE &&
+                fib_heap_steal(plain, heap, 0, NULL) == FIB_HEAP_ERROR_INVALID_STATE,
+                "Stable and non-stable heaps cannot be melded");
+    fib_heap_destroy(plain);
+
+    // heap holds even ids 2..62, other odd ids 3..63; heap's ties come first
+    TEST_ASSERT(fib_heap_union(heap, other) == FIB_HEAP_SUCCESS, "Union of two stable heaps");
+    fifo = true;
+    last_id = 0;
+    while (!fib_heap_empty(heap)) {
+        fib_node_t* node = fib_heap_extract_min(heap);
+        int id = *(int*)node->data;
+        if (id != (last_id == 62 ? 3 : last_id + 2)) {
+            fifo = false;
+        }
+        last_id = id;
+        free(node);
+    }
+    TEST_ASSERT(fifo && last_id == 63, "Union keeps each stable heap's insertion order");
+
+    // Later inserts into the union still follow the absorbed nodes
+    fib_heap_insert(heap, 5, &ids[0]);
+    fib_heap_insert(other, 5, &ids[1]);
+    fib_heap_union(heap, other);
+    fib_heap_insert(heap, 5, &ids[2]);
+    bool after = true;
+    for (int i = 0; i < 3; i++) {
+        fib_node_t* node = fib_heap_extract_min(heap);
+        after = after && *(int*)node->data == i;
+        free(node);
+    }
+    TEST_ASSERT(after, "Inserts after a union come after the absorbed ties");
+
+    // Steal moves whole trees; the thief's ties come out first, then the
+    // stolen ones, each in insertion order
+    for (int i = 0; i < 64; i++) {
+        fib_heap_insert(i % 2 ? other : heap, 3, &ids[i]);
+    }
+    free(fib_heap_extract_min(other));
+    size_t stolen = 0;
+    fib_heap_steal(heap, other, 8, &stolen);
+    fifo = stolen > 0;
+    int last_even = -1;
+    int last_odd = -1;
+    while (!fib_heap_empty(heap)) {
+        fib_node_t* node = fib_heap_extract_min(heap);
+        int id = *(int*)node->data;
+        if (id % 2 ? id < last_odd : (id < last_even || last_odd >= 0)) {
+            fifo = false;
+        }
+        *(id % 2 ? &last_odd : &last_even) = id;
+        free(node);
+    }
+    TEST_ASSERT(fifo && last_even == 62, "Steal keeps each stable heap's insertion order");
+    while (!fib_heap_empty(other)) {
+        free(fib_heap_extract_min(other));
+    }
+
+    fib_heap_destroy(other);
+    fib_heap_destroy(heap);
+    printf("\n");
+}
+
+// Test capacity-bounded top-K heap
+void test_bounded_heap() {
+    printf("=== Testing Bounded Heap ===\n");
+
+    fib_bounded_heap_t* heap = fib_bounded_heap_create(5);
+    TEST_ASSERT(heap != NULL, "Bounded heap creation");
+    TEST_ASSERT(fib_bounded_heap_create(0) == NULL, "Zero capacity is rejected");
+
+    bool kept;
+    fib_bounded_item_t evicted;
+    int keys[] = {50, 10, 40, 20, 30};
+    for (int i = 0; i < 5; i++) {
+        fib_bounded_heap_insert(heap, keys[i], NULL, &kept, &evicted);
+    }
+    TEST_ASSERT(fib_bounded_heap_size(heap) == 5, "Bounded heap fills to capacity");
+    TEST_ASSERT(fib_bounded_heap_worst(heap).key == 50, "Worst item is tracked");
+
+    fib_bounded_heap_insert(heap, 60, NULL, &kept, &evicted);
+    TEST_ASSERT(!kept && !evicted.valid, "Item worse than worst is rejected");
+
+    fib_bounded_heap_insert(heap, 5, NULL, &kept, &evicted);
+    TEST_ASSERT(kept && evicted.valid && evicted.key == 50, "Better item evicts the worst");
+    TEST_ASSERT(fib_bounded_heap_size(heap) == 5, "Size stays at capacity");
+    TEST_ASSERT(fib_bounded_heap_best(heap).key == 5, "Best item is tracked");
+    TEST_ASSERT(fib_bounded_heap_worst(heap).key == 40, "Worst item updated after eviction");
+
+    // Stream: the kept set must equal the K smallest keys seen
+    srand(11);
+    int seen_min[5] = {5, 10, 20, 30, 40};
+    for (int i = 0; i < 10000; i++) {
+        int key = rand() % 100000;
+        fib_bounded_heap_insert(heap, key, NULL, NULL, NULL);
+        if (key < seen_min[4]) {
+            int j = 4;
+            while (j > 0 && seen_min[j - 1] > key) {
+                seen_min[j] = seen_min[j - 1];
+                j--;
+            }
+            seen_min[j] = key;
+        }
+    }
+    bool matches = true;
+    for (int i = 0; i < 5; i++) {
+        fib_bounded_item_t item = fib_bounded_heap_extract_best(heap);
+        if (!item.valid || item.key != seen_min[i]) {
+            matches = false;
+        }
+    }
+    TEST_ASSERT(matches, "Bounded heap keeps the K smallest keys of a stream");
+    TEST_ASSERT(!fib_bounded_heap_extract_worst(heap).valid, "Extract from empty bounded heap");
+
+    fib_bounded_heap_destroy(heap);
+    printf("\n");
+}
+
+// Test batched decrease key
+void test_decrease_key_batch() {
+    printf("=== Testing Batched Decrease Key ===\n");
+
+    const int n = 1000;
+    fib_heap_t* heap = fib_heap_create();
+    fib_node_t* nodes[1000];
+
+    srand(5);
+    for (int i = 0; i < n; i++) {
+        nodes[i] = fib_heap_insert(heap, 10000 + rand() % 10000, NULL);
+    }
+    fib_node_t* first = fib_heap_extract_min(heap);
+    for (int i = 0; i < n; i++) {
+        if (nodes[i] == first) {
+            nodes[i] = nodes[n - 1];
+        }
+    }
+    free(first);
+
+    fib_node_t* batch[200];
+    int keys[200];
+    for (int i = 0; i < 200; i++) {
+        batch[i] = nodes[(i * 7) % (n - 1)];
+        keys[i] = fib_node_get_key(batch[i]) - 5000 - i;
+    }
+
+    int bad_keys[2] = {0, INT_MAX};
+    fib_node_t* bad_nodes[2] = {nodes[0], nodes[1]};
+    int key_before = fib_node_get_key(nodes[0]);
+    TEST_ASSERT(fib_heap_decrease_key_batch(heap, bad_nodes, bad_keys, 2) == FIB_HEAP_ERROR_INVALID_KEY,
+                "Batch with an increasing key is rejected");
+    TEST_ASSERT(fib_node_get_key(nodes[0]) == key_before, "Rejected batch leaves keys untouched");
+
+    TEST_ASSERT(fib_heap_decrease_key_batch(heap, batch, keys, 200) == FIB_HEAP_SUCCESS,
+                "Batched decrease key succeeds");
+
+    int expected_min = INT_MAX;
+    for (int i = 0; i < n - 1; i++) {
+        if (fib_node_get_key(nodes[i]) < expected_min) {
+            expected_min = fib_node_get_key(nodes[i]);
+        }
+    }
+    TEST_ASSERT(fib_node_get_key(fib_heap_minimum(heap)) == expected_min, "Minimum updated once after batch");
+
+    bool sorted = true;
+    int last = INT_MIN;
+    size_t count = 0;
+    while (!fib_heap_empty(heap)) {
+        fib_node_t* node = fib_heap_extract_min(heap);
+        if (node->key < last) {
+            sorted = false;
+        }
+        last = node->key;
+        count++;
+        free(node);
+    }
+    TEST_ASSERT(sorted && count == (size_t)(n - 1), "Heap order intact after batch");
+
+    fib_heap_destroy(heap);
+    printf("\n");
+}
+
+// Event loop test callbacks: record firing order, stop after the last timer
+static int fired_order[8];
+static int fired_count = 0;
+static void test_timer_cb(fib_event_loop_t* loop, void* user_ctx) {
+    fired_order[fired_count++] = *(int*)user_ctx;
+    if (fired_count == 3) {
+        fib_event_loop_stop(loop);
+    }
+}
+
+static int pipe_reads = 0;
+static void test_pipe_cb(fib_event_loop_t* loop, int fd, uint32_t events, void* user_ctx) {
+    (void)loop;
+    (void)events;
+    (void)user_ctx;
+    char byte;
+    if (read(fd, &byte, 1) == 1) {
+        pipe_reads++;
+    }
+}
+
+// Test the timerfd-driven event loop
+void test_event_loop() {
+    printf("=== Testing Event Loop ===\n");
+
+    fib_event_loop_t* loop = fib_event_loop_create();
+    TEST_ASSERT(loop != NULL, "Event loop creation");
+
+    int ids[4] = {0, 1, 2, 3};
+    fired_count = 0;
+    fib_event_loop_add_timer(loop, 30, test_timer_cb, &ids[2]);
+    fib_event_loop_add_timer(loop, 10, test_timer_cb, &ids[0]);
+    fib_timer_t* cancelled = fib_event_loop_add_timer(loop, 15, test_timer_cb, &ids[3]);
+    fib_event_loop_add_timer(loop, 20, test_timer_cb, &ids[1]);
+    TEST_ASSERT(fib_event_loop_cancel_timer(loop, cancelled) == FIB_HEAP_SUCCESS, "Cancel pending timer");
+
+    // Adding a later timer must not re-arm the timerfd
+    size_t arms_before = fib_event_loop_get_stats(loop).timerfd_arms;
+    fib_timer_t* late = fib_event_loop_add_timer(loop, 5000, test_timer_cb, &ids[3]);
+    TEST_ASSERT(fib_event_loop_get_stats(loop).timerfd_arms == arms_before,
+                "Timer behind the minimum does not re-arm");
+
+    int fds[2];
+    TEST_ASSERT(pipe(fds) == 0, "Create pipe");
+    pipe_reads = 0;
+    fib_event_loop_add_fd(loop, fds[0], EPOLLIN, test_pipe_cb, NULL);
+    TEST_ASSERT(write(fds[1], "x", 1) == 1, "Write to pipe");
+
+    uint64_t start = fib_event_loop_now_ms(loop);
+    fib_event_loop_run(loop);
+    uint64_t elapsed = fib_event_loop_now_ms(loop) - start;
+
+    TEST_ASSERT(pipe_reads == 1, "File descriptor callback runs");
+    TEST_ASSERT(fired_count == 3 && fired_order[0] == 0 && fired_order[1] == 1 && fired_order[2] == 2,
+                "Timers fire in deadline order, cancelled timer skipped");
+    TEST_ASSERT(elapsed >= 29, "Timers do not fire early");
+    TEST_ASSERT(fib_event_loop_get_stats(loop).pending_timers == 1, "Late timer still pending");
+
+    fib_event_loop_cancel_timer(loop, late);
+    fib_event_loop_remove_fd(loop, fds[0]);
+    close(fds[0]);
+    close(fds[1]);
+    fib_event_loop_destroy(loop);
+    printf("\n");
+}
+
+// Test monotone (radix) mode against a simple Dijkstra-like workload
+void test_monotone_mode() {
+    printf("=== Testing Monotone Mode ===\n");
+
+    fib_heap_t* heap = fib_heap_create();
+    TEST_ASSERT(fib_heap_set_monotone(heap, true) == FIB_HEAP_SUCCESS, "Enable monotone mode");
+    TEST_ASSERT(fib_heap_set_stable(heap, true) == FIB_HEAP_ERROR_INVALID_STATE,
+                "Stable and monotone modes are exclusive");
+
+    // Keys spanning negative and positive values
+    fib_node_t* nodes[200];
+    unsigned int seed = 7;
+    for (int i = 0; i < 200; i++) {
+        nodes[i] = fib_heap_insert(heap, (int)(rand_r(&seed) % 20000) - 10000, NULL);
+    }
+    TEST_ASSERT(fib_heap_size(heap) == 200, "Monotone inserts");
+
+    // Extract in order while decreasing, deleting and inserting above the floor
+    int previous = INT_MIN;
+    bool ordered = true;
+    bool decreases_ok = true;
+    int extracted = 0;
+    fib_node_t* node;
+    while ((node = fib_heap_extract_min(heap)) != NULL) {
+        ordered = ordered && node->key >= previous;
+        previous = node->key;
+        for (int i = 0; i < 200; i++) {
+            if (nodes[i] == node) {
+                nodes[i] = NULL;
+            }
+        }
+        fib_heap_free_node(heap, node);
+        extracted++;
+
+        if (extracted % 10 == 0) {
+            for (int i = 0; i < 200; i++) {
+                if (nodes[i] && nodes[i]->key > previous + 10) {
+                    decreases_ok = decreases_ok &&
+                        fib_heap_decrease_key(heap, nodes[i], previous + 5) == FIB_HEAP_SUCCESS;
+                    break;
+                }
+            }
+        }
+        if (extracted == 50) {
+            for (int i = 199; i >= 0; i--) {
+                if (nodes[i]) {
+                    fib_heap_delete_node(heap, nodes[i]);
+                    nodes[i] = NULL;
+                    extracted++;
+                    break;
+                }
+            }
+        }
+    }
+    TEST_ASSERT(ordered && decreases_ok, "Extracted keys are non-decreasing");
+    TEST_ASSERT(extracted == 200, "Every node extracted or deleted once");
+
+    // Keys below the last extracted key are rejected
+    fib_node_t* floor_node = fib_heap_insert(heap, previous, NULL);
+    TEST_ASSERT(floor_node != NULL, "Insert at the floor accepted");
+    TEST_ASSERT(fib_heap_insert(heap, previous - 1, NULL) == NULL, "Insert below the floor rejected");
+    TEST_ASSERT(fib_heap_get_statistics(heap).monotone_violations == 1, "Violation counted");
+    fib_node_t* checked = floor_node;
+    TEST_ASSERT(fib_heap_insert_checked(heap, previous - 1, NULL, &checked) == FIB_HEAP_ERROR_INVALID_KEY &&
+                checked == NULL && fib_heap_get_statistics(heap).monotone_violations == 2,
+                "Checked insert reports a key below the floor");
+    TEST_ASSERT(fib_heap_insert_checked(heap, previous, NULL, &checked) == FIB_HEAP_SUCCESS &&
+                checked && checked->key == previous, "Checked insert at the floor");
+    fib_heap_delete_node(heap, checked);
+    fib_node_t* above = fib_heap_insert(heap, previous + 100, NULL);
+    TEST_ASSERT(fib_heap_decrease_key(heap, above, previous - 1) == FIB_HEAP_ERROR_INVALID_KEY,
+                "Decrease below the floor rejected");
+
+    fib_heap_t* other = fib_heap_create();
+    TEST_ASSERT(fib_heap_union(heap, other) == FIB_HEAP_ERROR_INVALID_STATE, "Union across modes rejected");
+    fib_heap_set_monotone(other, true);
+    fib_heap_insert(other, previous + 1, NULL);
+    TEST_ASSERT(fib_heap_union(heap, other) == FIB_HEAP_SUCCESS && fib_heap_size(heap) == 3,
+                "Monotone union");
+    TEST_ASSERT(fib_heap_minimum(heap) == floor_node, "Minimum after union");
+
+    fib_heap_destroy(other);
+    fib_heap_destroy(heap);
+    printf("\n");
+}
+
+// Allocator that checks sizes: every free must match its alloc
+typedef struct {
+    size_t live_blocks;
+    size_t live_bytes;
+    size_t allocs;
+    size_t batches;             // free_batch calls
+} counting_allocator_t;
+
+static void* counting_alloc(void* user_ctx, size_t size) {
+    counting_allocator_t* counter = (counting_allocator_t*)user_ctx;
+    counter->live_blocks++;
+    counter->live_bytes += size;
+    counter->allocs++;
+    return malloc(size);
+}
+
+static void counting_free(void* user_ctx, void* ptr, size_t size) {
+    counting_allocator_t* counter = (counting_allocator_t*)user_ctx;
+    counter->live_blocks--;
+    counter->live_bytes -= size;
+    free(ptr);
+}
+
+static void counting_free_batch(void* user_ctx, void* const ptrs[], size_t count, size_t size) {
+    counting_allocator_t* counter = (counting_allocator_t*)user_ctx;
+    counter->batches++;
+    for (size_t i = 0; i < count; i++) {
+        counting_free(user_ctx, ptrs[i], size);
+    }
+}
+
+// Test allocator hooks and the arena allocator
+void test_allocator() {
+    printf("=== Testing Allocators ===\n");
+
+    counting_allocator_t counter = {0, 0, 0, 0};
+    fib_heap_allocator_t counting = {counting_alloc, counting_free, &counter, NULL, NULL, NULL};
+    fib_heap_t* heap = fib_heap_create_with_allocator(&counting);
+    TEST_ASSERT(heap != NULL && counter.live_blocks == 1, "Heap itself comes from the allocator");
+
+    fib_node_t* nodes[100];
+    for (int i = 0; i < 100; i++) {
+        nodes[i] = fib_heap_insert(heap, (i * 37) % 100, NULL);
+    }
+    fib_heap_decrease_key(heap, nodes[50], -1);
+    fib_heap_delete_node(heap, nodes[10]);
+    for (int i = 0; i < 40; i++) {
+        fib_heap_free_node(heap, fib_heap_extract_min(heap));
+    }
+    TEST_ASSERT(counter.allocs > 101, "Nodes and consolidation buffers use the allocator");
+    TEST_ASSERT(fib_heap_compact(heap, 0, NULL, NULL, NULL) == FIB_HEAP_ERROR_INVALID_STATE,
+                "Compaction refused without an aligned allocation hook");
+
+    fib_heap_t* plain = fib_heap_create();
+    fib_heap_insert(plain, 1, NULL);
+    TEST_ASSERT(fib_heap_union(heap, plain) == FIB_HEAP_ERROR_INVALID_STATE,
+                "Union across allocators rejected");
+    TEST_ASSERT(fib_heap_steal(heap, plain, 0, NULL) == FIB_HEAP_ERROR_INVALID_STATE,
+                "Steal across allocators rejected");
+    fib_heap_destroy(plain);
+
+    fib_heap_destroy(heap);
+    TEST_ASSERT(counter.live_blocks == 0 && counter.live_bytes == 0,
+                "Every block freed with the size it was allocated with");
+
+    fib_heap_allocator_t broken = {counting_alloc, NULL, &counter, NULL, NULL, NULL};
+    TEST_ASSERT(fib_heap_create_with_allocator(&broken) == NULL, "Incomplete allocator rejected");
+
+    // Arena, local to the calling thread's node (bound or not, it must work)
+    fib_arena_t* arena = fib_arena_create(0, fib_numa_current_node());
+    TEST_ASSERT(arena != NULL, "Create NUMA-local arena");
+    fib_heap_allocator_t from_arena = fib_arena_allocator(arena);
+    fib_heap_t* a = fib_heap_create_with_allocator(&from_arena);
+    fib_heap_t* b = fib_heap_create_with_allocator(&from_arena);
+    for (int i = 0; i < 5000; i++) {
+        fib_heap_insert(i % 2 ? a : b, 5000 - i, NULL);
+    }
+    TEST_ASSERT(fib_heap_union(a, b) == FIB_HEAP_SUCCESS && fib_heap_size(a) == 5000,
+                "Union of heaps sharing an arena");
+    fib_heap_destroy(b);
+
+    bool ordered = true;
+    int previous = INT_MIN;
+    for (int i = 0; i < 5000; i++) {
+        fib_node_t* node = fib_heap_extract_min(a);
+        ordered = ordered && node && node->key >= previous;
+        previous = node ? node->key : previous;
+        fib_heap_free_node(a, node);
+    }
+    TEST_ASSERT(ordered, "Arena-backed heap extracts in order");
+
+    // Compaction's node blocks come from the arena as well
+    for (int i = 0; i < 1000; i++) {
+        fib_heap_insert(a, i, NULL);
+    }
+    fib_heap_free_node(a, fib_heap_extract_min(a));
+    size_t mapped_before = fib_arena_get_stats(arena).bytes_mapped;
+    bool done = false;
+    TEST_ASSERT(fib_heap_compact(a, 0, NULL, NULL, &done) == FIB_HEAP_SUCCESS && done &&
+                fib_arena_get_stats(arena).bytes_mapped > mapped_before,
+                "Arena-backed heap compacts into arena memory");
+    while (!fib_heap_empty(a)) {
+        fib_heap_free_node(a, fib_heap_extract_min(a));
+    }
+
+    fib_arena_stats_t stats = fib_arena_get_stats(arena);
+    TEST_ASSERT(stats.chunks >= 1 && stats.bytes_mapped >= stats.bytes_in_use,
+                "Arena counters are consistent");
+    fib_heap_destroy(a);
+    TEST_ASSERT(fib_arena_get_stats(arena).bytes_in_use == 0, "Arena fully released by destroy");
+    fib_arena_destroy(arena);
+
+    // Huge-page chunks; coverage depends on the kernel, consistency does not
+    arena = fib_arena_create(0, FIB_ARENA_ANY_NODE);
+    TEST_ASSERT(fib_arena_set_pages(arena, FIB_ARENA_PAGES_HUGETLB) == FIB_HEAP_SUCCESS,
+                "Select huge pages before the first allocation");
+    from_arena = fib_arena_allocator(arena);
+    a = fib_heap_create_with_allocator(&from_arena);
+    TEST_ASSERT(fib_arena_set_pages(arena, FIB_ARENA_PAGES_BASE) == FIB_HEAP_ERROR_INVALID_STATE,
+                "Page size fixed once memory is mapped");
+    for (int i = 0; i < 50000; i++) {
+        fib_heap_insert(a, i, NULL);
+    }
+    size_t bytes = 0, huge_bytes = 0;
+    fib_arena_page_usage(arena, &bytes, &huge_bytes);
+    stats = fib_arena_get_stats(arena);
+    TEST_ASSERT(stats.hugetlb_chunks + stats.hugetlb_fallbacks == stats.chunks,
+                "Every chunk is hugetlb or a THP fallback");
+    TEST_ASSERT(bytes == stats.chunks * (size_t)2 * 1024 * 1024 && huge_bytes <= bytes,
+                "Huge-page coverage measured");
+    fib_heap_statistics_t heap_stats = fib_heap_get_statistics(a);
+    TEST_ASSERT(heap_stats.memory_bytes == stats.bytes_mapped &&
+                heap_stats.huge_page_bytes == stats.huge_page_bytes &&
+                heap_stats.huge_page_bytes <= heap_stats.memory_bytes &&
+                (heap_stats.huge_page_bytes > 0) == (heap_stats.huge_page_coverage > 0),
+                "Huge-page coverage in the heap statistics");
+    fib_heap_destroy(a);
+    fib_arena_destroy(arena);
+
+    TEST_ASSERT(fib_numa_node_count() >= 1 && fib_numa_current_node() < fib_numa_node_count(),
+                "NUMA topology queries");
+    printf("\n");
+}
+
+// Callback for test_drain_sorted: checks order and counts elements
+typedef struct {
+    int previous;
+    size_t count;
+    bool ordered;
+} drain_check_t;
+
+static void drain_check(int key, void* data, void* user_ctx) {
+    drain_check_t* check = (drain_check_t*)user_ctx;
+    (void)data;
+    check->ordered = check->ordered && key >= check->previous;
+    check->previous = key;
+    check->count++;
+}
+
+static int compare_ints(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Test sorted drain
+void test_drain_sorted() {
+    printf("=== Testing Sorted Drain ===\n");
+
+    // A consolidated, compacted forest with cuts, negative keys and duplicates
+    fib_heap_t* heap = fib_heap_create();
+    static int ids[2000];
+    static int keys[2000];
+    fib_node_t* nodes[2000];
+    unsigned int seed = 11;
+    for (int i = 0; i < 2000; i++) {
+        ids[i] = i;
+        keys[i] = (int)(rand_r(&seed) % 3000) - 1000;
+        nodes[i] = fib_heap_insert(heap, keys[i], &ids[i]);
+    }
+    fib_node_t* min = fib_heap_extract_min(heap);
+    keys[*(int*)min->data] = INT_MAX;       // Not expected in the drain
+    fib_heap_free_node(heap, min);
+    for (int i = 0; i < 2000; i += 7) {
+        if (keys[i] != INT_MAX) {
+            keys[i] -= 500;
+            fib_heap_decrease_key(heap, nodes[i], keys[i]);
+        }
+    }
+    bool done = false;
+    fib_heap_compact(heap, 500, NULL, NULL, &done);
+
+    size_t n = fib_heap_size(heap);
+    int* drained = malloc(n * sizeof(int));
+    void** data = malloc(n * sizeof(void*));
+    TEST_ASSERT(fib_heap_drain_sorted(heap, drained, data) == FIB_HEAP_SUCCESS, "Drain to arrays");
+    TEST_ASSERT(fib_heap_empty(heap) && fib_heap_minimum(heap) == NULL, "Heap empty after drain");
+
+    qsort(keys, 2000, sizeof(int), compare_ints);
+    bool matches = true;
+    for (size_t i = 0; i < n; i++) {
+        matches = matches && drained[i] == keys[i];
+    }
+    TEST_ASSERT(n == 1999 && matches, "Drained keys are the remaining keys, sorted");
+    free(drained);
+    free(data);
+
+    TEST_ASSERT(fib_heap_insert(heap, 3, NULL) != NULL && fib_heap_size(heap) == 1,
+                "Heap usable after drain");
+    fib_heap_destroy(heap);
+
+    // Stable mode: equal keys come out in insertion order
+    heap = fib_heap_create();
+    fib_heap_set_stable(heap, true);
+    for (int i = 0; i < 1000; i++) {
+        fib_heap_insert(heap, (i * 7) % 5, &ids[i]);
+    }
+    fib_heap_free_node(heap, fib_heap_extract_min(heap));
+    int stable_keys[999];
+    void* stable_data[999];
+    fib_heap_drain_sorted(heap, stable_keys, stable_data);
+    bool fifo = true;
+    for (int i = 1; i < 999; i++) {
+        if (stable_keys[i] == stable_keys[i - 1]) {
+            fifo = fifo && *(int*)stable_data[i] > *(int*)stable_data[i - 1];
+        } else {
+            fifo = fifo && stable_keys[i] > stable_keys[i - 1];
+        }
+    }
+    TEST_ASSERT(fifo, "Stable drain keeps ties in insertion order");
+    fib_heap_destroy(heap);
+
+    // Callback variant on a monotone heap; the floor moves to the last key
+    heap = fib_heap_create();
+    fib_heap_set_monotone(heap, true);
+    for (int i = 0; i < 500; i++) {
+        fib_heap_insert(heap, (i * 37) % 400, NULL);
+    }
+    fib_heap_free_node(heap, fib_heap_extract_min(heap));
+    drain_check_t check = {INT_MIN, 0, true};
+    TEST_ASSERT(fib_heap_drain_sorted_fn(heap, drain_check, &check) == FIB_HEAP_SUCCESS &&
+                check.count == 499 && check.ordered, "Callback drain of a monotone heap");
+    TEST_ASSERT(fib_heap_insert(heap, check.previous - 1, NULL) == NULL, "Floor is the last drained key");
+    TEST_ASSERT(fib_heap_drain_sorted_fn(heap, NULL, NULL) == FIB_HEAP_ERROR_NULL_POINTER,
+                "Callback required");
+    fib_heap_destroy(heap);
+
+    // Every node, cancelled ones included, goes back in one free_batch call
+    counting_allocator_t counter = {0, 0, 0, 0};
+    fib_heap_allocator_t counting = {counting_alloc, counting_free, &counter, NULL, counting_free_batch, NULL};
+    heap = fib_heap_create_with_allocator(&counting);
+    for (int i = 0; i < 300; i++) {
+        nodes[i] = fib_heap_insert(heap, (i * 31) % 300, NULL);
+    }
+    fib_heap_free_node(heap, fib_heap_extract_min(heap));
+    for (int i = 1; i < 300; i += 30) {
+        fib_heap_cancel(heap, nodes[i]);
+    }
+    size_t blocks_before = counter.live_blocks;
+    TEST_ASSERT(fib_heap_drain_sorted(heap, NULL, NULL) == FIB_HEAP_SUCCESS && counter.batches == 1 &&
+                counter.live_blocks == blocks_before - 299, "Nodes released in one batch");
+    fib_heap_destroy(heap);
+    TEST_ASSERT(counter.live_blocks == 0, "Drained heap leaves nothing behind");
+
+    fib_arena_t* arena = fib_arena_create(0, FIB_ARENA_ANY_NODE);
+    fib_heap_allocator_t from_arena = fib_arena_allocator(arena);
+    heap = fib_heap_create_with_allocator(&from_arena);
+    size_t in_use = fib_arena_get_stats(arena).bytes_in_use;
+    for (int i = 0; i < 300; i++) {
+        fib_heap_insert(heap, 300 - i, NULL);
+    }
+    fib_heap_drain_sorted(heap, NULL, NULL);
+    TEST_ASSERT(fib_arena_get_stats(arena).bytes_in_use == in_use &&
+                fib_heap_insert(heap, 1, NULL) != NULL, "Arena takes a drained heap back in one splice");
+    fib_heap_destroy(heap);
+    fib_arena_destroy(arena);
+    printf("\n");
+}
+
+// Test tombstone cancellation and purge
+void test_cancel() {
+    printf("=== Testing Cancel and Purge ===\n");
+
+    fib_heap_t* heap = fib_heap_create();
+    fib_node_t* nodes[1000];
+    for (int i = 0; i < 1000; i++) {
+        nodes[i] = fib_heap_insert(heap, (i * 389) % 1000, &nodes[i]);
+    }
+    fib_heap_free_node(heap, fib_heap_extract_min(heap));   // Key 0, builds trees
+
+    // Cancel every key below 100 (the minimum among them) and every odd key
+    bool cancelled = true;
+    for (int i = 0; i < 1000; i++) {
+        int key = (i * 389) % 1000;
+        if (key != 0 && (key < 100 || key % 2)) {
+            cancelled = cancelled && fib_heap_cancel(heap, nodes[i]) == FIB_HEAP_SUCCESS;
+        }
+    }
+    bool payloads = true;
+    for (int i = 0; i < 1000; i++) {
+        if ((i * 389) % 1000 != 0) {
+            payloads = payloads && fib_node_get_data(nodes[i]) == &nodes[i];
+        }
+    }
+    TEST_ASSERT(payloads, "Cancel leaves the payload in place");
+    size_t dead = 99 + 450;
+    fib_heap_statistics_t stats = fib_heap_get_statistics(heap);
+    TEST_ASSERT(cancelled && fib_heap_size(heap) == 999 - dead, "Size reports live nodes");
+    TEST_ASSERT(stats.dead_nodes == dead && stats.total_nodes == 999 - dead,
+                "Statistics report dead nodes");
+
+    fib_node_t* min = fib_heap_extract_min(heap);
+    TEST_ASSERT(min && min->key == 100, "Extract-min skips cancelled nodes");
+    fib_heap_free_node(heap, min);
+    TEST_ASSERT(fib_heap_get_statistics(heap).dead_nodes < dead, "Extract-min released dead roots");
+
+    TEST_ASSERT(fib_heap_purge(heap) == FIB_HEAP_SUCCESS &&
+                fib_heap_get_statistics(heap).dead_nodes == 0 && fib_heap_size(heap) == 449,
+                "Purge removes every dead node");
+    bool ordered = true;
+    int previous = 100;
+    while ((min = fib_heap_extract_min(heap)) != NULL) {
+        ordered = ordered && min->key > previous && min->key % 2 == 0;
+        previous = min->key;
+        fib_heap_free_node(heap, min);
+    }
+    TEST_ASSERT(ordered && previous == 998, "Live keys survive the purge in order");
+    fib_heap_destroy(heap);
+
+    // Threshold-triggered purge; dead handles are rejected until then
+    heap = fib_heap_create();
+    fib_heap_set_purge_threshold(heap, 10);
+    for (int i = 0; i < 100; i++) {
+        nodes[i] = fib_heap_insert(heap, i, NULL);
+    }
+    fib_heap_free_node(heap, fib_heap_extract_min(heap));
+    for (int i = 1; i < 10; i++) {
+        fib_heap_cancel(heap, nodes[i * 10]);
+    }
+    TEST_ASSERT(fib_heap_get_statistics(heap).dead_nodes == 9, "Below the threshold nothing is purged");
+    TEST_ASSERT(fib_heap_decrease_key(heap, nodes[10], 0) == FIB_HEAP_ERROR_INVALID_HANDLE &&
+                fib_heap_cancel(heap, nodes[10]) == FIB_HEAP_ERROR_INVALID_HANDLE &&
+                fib_heap_delete_node(heap, nodes[10]) == FIB_HEAP_ERROR_INVALID_HANDLE,
+                "Dead handles are rejected");
+    fib_heap_cancel(heap, nodes[5]);
+    TEST_ASSERT(fib_heap_get_statistics(heap).dead_nodes == 0 && fib_heap_size(heap) == 89,
+                "Reaching the threshold purges");
+
+    // Union and steal purge the heap giving up nodes; drain skips dead nodes
+    fib_heap_t* other = fib_heap_create();
+    for (int i = 0; i < 50; i++) {
+        nodes[i] = fib_heap_insert(other, 1000 + i, NULL);
+    }
+    for (int i = 0; i < 50; i += 5) {
+        fib_heap_cancel(other, nodes[i]);
+    }
+    fib_heap_union(heap, other);
+    TEST_ASSERT(fib_heap_size(heap) == 129 && fib_heap_get_statistics(heap).dead_nodes == 0 &&
+                fib_heap_size(other) == 0, "Union purges the absorbed heap");
+
+    fib_heap_cancel(heap, nodes[1]);
+    fib_heap_cancel(heap, nodes[49]);
+    fib_heap_t* thief = fib_heap_create();
+    size_t stolen = 0;
+    fib_heap_steal(thief, heap, 60, &stolen);
+    TEST_ASSERT(fib_heap_size(thief) == stolen && fib_heap_size(heap) + stolen == 127 &&
+                fib_heap_get_statistics(heap).dead_nodes == 0, "Steal purges the victim");
+    fib_heap_union(heap, thief);
+
+    fib_heap_cancel(heap, nodes[2]);
+    int drained[126];
+    TEST_ASSERT(fib_heap_size(heap) == 126 &&
+                fib_heap_drain_sorted(heap, drained, NULL) == FIB_HEAP_SUCCESS &&
+                fib_heap_size(heap) == 0 && fib_heap_get_statistics(heap).dead_nodes == 0,
+                "Drain releases dead nodes");
+    bool skipped = drained[0] == 1 && drained[88] == 99 && drained[89] == 1003 && drained[125] == 1048;
+    for (int i = 89; i < 126; i++) {
+        skipped = skipped && drained[i] % 5 != 0;
+    }
+    TEST_ASSERT(skipped, "Drain emits only live keys");
+
+    // Cancelling everything leaves an empty heap
+    for (int i = 0; i < 20; i++) {
+        nodes[i] = fib_heap_insert(heap, i, NULL);
+    }
+    fib_heap_free_node(heap, fib_heap_extract_min(heap));
+    for (int i = 1; i < 20; i++) {
+        fib_heap_cancel(heap, nodes[i]);
+    }
+    TEST_ASSERT(fib_heap_empty(heap) && fib_heap_minimum(heap) == NULL &&
+                fib_heap_get_statistics(heap).dead_nodes == 0, "All-dead heap is empty");
+    fib_heap_destroy(heap);
+    fib_heap_destroy(other);
+    fib_heap_destroy(thief);
+    printf("\n");
+}
+
+// Test the external-memory queue with a tiny head, so runs spill and merge
+void test_extmem() {
+    printf("=== Testing External-Memory Queue ===\n");
+
+    static int keys[5000];
+    static bool popped[5000];
+    const fib_extmem_io_t modes[2] = {FIB_EXTMEM_IO_BUFFERED, FIB_EXTMEM_IO_MMAP};
+    for (int m = 0; m < 2; m++) {
+        fib_extmem_config_t config = {64, 4096, 4, NULL, modes[m]};
+        fib_extmem_t* queue = fib_extmem_create(&config);
+        TEST_ASSERT(queue != NULL, m ? "Create mmap queue" : "Create buffered queue");
+
+        unsigned int seed = 23;
+        for (int i = 0; i < 5000; i++) {
+            keys[i] = (int)(rand_r(&seed) % 100000);
+            popped[i] = false;
+            fib_extmem_push(queue, keys[i], (uint64_t)i);
+        }
+        // Some ids are decreased twice, some after they were spilled
+        bool updated = true;
+        for (int i = 0; i < 5000; i += 7) {
+            keys[i] -= 60000;
+            updated = updated && fib_extmem_decrease_key(queue, (uint64_t)i, keys[i]) == FIB_HEAP_SUCCESS;
+            if (i % 3 == 0) {
+                keys[i] -= 1;
+                fib_extmem_decrease_key(queue, (uint64_t)i, keys[i]);
+            }
+        }
+        fib_extmem_stats_t stats = fib_extmem_get_stats(queue);
+        TEST_ASSERT(updated && fib_extmem_size(queue) == 5000, "Size counts items, not copies");
+        TEST_ASSERT(stats.runs_written > 0 && stats.merges > 0 && stats.runs <= 4 &&
+                    stats.head_size <= 64 && stats.bytes_written > 0,
+                    "Head spills to runs and runs are merged");
+
+        int peek_key = 0;
+        uint64_t peek_id = 0;
+        fib_extmem_peek(queue, &peek_key, &peek_id);
+        bool ordered = true;
+        bool exact = true;
+        int previous = INT_MIN;
+        int count = 0;
+        int key;
+        uint64_t id;
+        while (fib_extmem_pop(queue, &key, &id) == FIB_HEAP_SUCCESS) {
+            if (count == 0) {
+                exact = exact && key == peek_key && id == peek_id;
+            }
+            ordered = ordered && key >= previous;
+            exact = exact && id < 5000 && !popped[id] && keys[id] == key;
+            if (id < 5000) {
+                popped[id] = true;
+            }
+            previous = key;
+            count++;
+        }
+        stats = fib_extmem_get_stats(queue);
+        TEST_ASSERT(ordered && count == 5000, "Pops come out in key order");
+        TEST_ASSERT(exact, "Each id pops once, with its latest key");
+        TEST_ASSERT(fib_extmem_size(queue) == 0 && fib_extmem_peek(queue, NULL, NULL) == FIB_HEAP_ERROR_EMPTY_HEAP &&
+                    stats.runs == 0 && stats.stale_dropped == 5000 / 7 + 1 + 5000 / 21 + 1,
+                    "Superseded copies are dropped");
+        TEST_ASSERT(stats.bytes_read > 0 && stats.bytes_read <= stats.bytes_written,
+                    "Run files are read back once");
+        fib_extmem_destroy(queue);
+    }
+
+    // Only queued ids can be updated, and only downwards
+    fib_extmem_config_t config = {4, 4096, 4, NULL, FIB_EXTMEM_IO_BUFFERED};
+    fib_extmem_t* queue = fib_extmem_create(&config);
+    for (int i = 0; i < 20; i++) {
+        fib_extmem_push(queue, 100 + i, (uint64_t)i);
+    }
+    TEST_ASSERT(fib_extmem_push(queue, 5, 3) == FIB_HEAP_ERROR_INVALID_HANDLE, "Pushing a queued id is rejected");
+    TEST_ASSERT(fib_extmem_decrease_key(queue, 99, 1) == FIB_HEAP_ERROR_INVALID_HANDLE,
+                "Decrease-key of an unknown id is rejected");
+    TEST_ASSERT(fib_extmem_decrease_key(queue, 17, 200) == FIB_HEAP_ERROR_INVALID_KEY &&
+                fib_extmem_decrease_key(queue, 17, 117) == FIB_HEAP_SUCCESS,
+                "Decrease-key to a larger key is rejected");
+    int key;
+    uint64_t id;
+    fib_extmem_pop(queue, &key, &id);
+    TEST_ASSERT(id == 0 && fib_extmem_decrease_key(queue, 0, 1) == FIB_HEAP_ERROR_INVALID_HANDLE,
+                "Decrease-key of a popped id is rejected");
+    TEST_ASSERT(fib_extmem_decrease_key(queue, 18, 50) == FIB_HEAP_SUCCESS &&
+                fib_extmem_push(queue, 300, 0) == FIB_HEAP_SUCCESS && fib_extmem_size(queue) == 20,
+                "Size stays exact after rejected updates");
+    int count = 0;
+    while (fib_extmem_pop(queue, &key, &id) == FIB_HEAP_SUCCESS) {
+        count++;
+    }
+    TEST_ASSERT(count == 20, "Every queued id pops once");
+    fib_extmem_destroy(queue);
+    printf("\n");
+}
+
+// Test batched insert
+void test_insert_batch() {
+    printf("=== Testing Batched Insert ===\n");
+
+    fib_heap_t* heap = fib_heap_create();
+    fib_heap_set_stable(heap, true);
+    fib_heap_insert(heap, 50, NULL);
+
+    int keys[300];
+    int ids[300];
+    void* data[300];
+    fib_node_t* nodes[300];
+    for (int i = 0; i < 300; i++) {
+        keys[i] = 100 - i % 150;
+        ids[i] = i;
+        data[i] = &ids[i];
+    }
+    TEST_ASSERT(fib_heap_insert_batch(heap, keys, data, 300, nodes) == FIB_HEAP_SUCCESS,
+                "Batched insert succeeds");
+    TEST_ASSERT(fib_heap_size(heap) == 301 && nodes[299]->key == keys[299] && nodes[0]->data == &ids[0],
+                "Handles returned in input order");
+    TEST_ASSERT(fib_heap_minimum(heap) == nodes[149], "Minimum updated once, first of equal keys");
+    TEST_ASSERT(fib_heap_insert_batch(heap, NULL, NULL, 0, NULL) == FIB_HEAP_SUCCESS,
+                "Empty batch is accepted");
+    TEST_ASSERT(fib_heap_decrease_key(heap, nodes[10], -5) == FIB_HEAP_SUCCESS,
+                "Batched handles support decrease key");
+
+    bool sorted = true;
+    int last = INT_MIN;
+    size_t count = 0;
+    fib_node_t* node;
+    while ((node = fib_heap_extract_min(heap)) != NULL) {
+        sorted = sorted && node->key >= last;
+        last = node->key;
+        count++;
+        free(node);
+    }
+    TEST_ASSERT(sorted && count == 301, "Heap order intact after batched insert");
+
+    fib_heap_set_stable(heap, false);
+    fib_heap_set_monotone(heap, true);
+    fib_heap_insert(heap, 10, NULL);
+    free(fib_heap_extract_min(heap));
+    int low[2] = {20, 5};
+    TEST_ASSERT(fib_heap_insert_batch(heap, low, NULL, 2, NULL) == FIB_HEAP_ERROR_INVALID_KEY &&
+                fib_heap_size(heap) == 0, "Monotone batch below the floor is rejected whole");
+    int high[3] = {30, 12, 20};
+    fib_heap_insert_batch(heap, high, NULL, 3, NULL);
+    node = fib_heap_extract_min(heap);
+    TEST_ASSERT(node && node->key == 12 && fib_heap_size(heap) == 2, "Monotone batch inserts every key");
+    free(node);
+
+    fib_heap_destroy(heap);
+    printf("\n");
+}
+
+// Producer for the MPSC front-end test: keys encode producer and sequence
+typedef struct {
+    fib_mpsc_t* queue;
+    int producer;
+    int count;
+} test_mpsc_producer_t;
+
+static void test_count_relocate_cb(fib_node_t* old_node, fib_node_t* new_node, void* user_ctx) {
+    (void)old_node;
+    (void)new_node;
+    (*(int*)user_ctx)++;
+}
+
+static void* test_mpsc_producer(void* arg) {
+    test_mpsc_producer_t* producer = (test_mpsc_producer_t*)arg;
+    for (int i = 0; i < producer->count; i++) {
+        while (fib_mpsc_insert(producer->queue, i * 8 + producer->producer, NULL, NULL) != FIB_HEAP_SUCCESS) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+// Test the lock-free insert front-end
+void test_mpsc() {
+    printf("=== Testing MPSC Insert Front-End ===\n");
+
+    fib_heap_t* heap = fib_heap_create();
+    fib_mpsc_t* queue = fib_mpsc_create(heap, 8);
+    TEST_ASSERT(queue != NULL && fib_mpsc_heap(queue) == heap, "MPSC front-end creation");
+
+    fib_mpsc_ticket_t tickets[8];
+    bool queued = true;
+    for (int i = 0; i < 8; i++) {
+        queued = queued && fib_mpsc_insert(queue, 100 + i, NULL, &tickets[i]) == FIB_HEAP_SUCCESS;
+    }
+    TEST_ASSERT(queued, "Inserts queued up to capacity");
+    TEST_ASSERT(fib_mpsc_insert(queue, 1, NULL, NULL) == FIB_HEAP_ERROR_INVALID_STATE &&
+                fib_mpsc_get_stats(queue).full == 1, "Full ring refuses without blocking");
+    TEST_ASSERT(fib_heap_empty(heap) && fib_mpsc_ticket_state(&tickets[3]) == FIB_MPSC_PENDING,
+                "Queued inserts do not touch the heap");
+
+    TEST_ASSERT(fib_mpsc_drain(queue) == 8 && fib_heap_size(heap) == 8, "Drain applies queued inserts");
+    fib_mpsc_handle_t handle = fib_mpsc_ticket_wait(&tickets[5]);
+    TEST_ASSERT(fib_mpsc_ticket_state(&tickets[5]) == FIB_MPSC_READY && handle.node &&
+                ((const fib_node_t*)handle.node)->key == 105, "Ticket resolves to the inserted node");
+    fib_mpsc_stats_t stats = fib_mpsc_get_stats(queue);
+    TEST_ASSERT(stats.batches == 1 && stats.max_batch == 8, "Inserts spliced as one chain");
+
+    // Decrease-key follows an insert from the same producer
+    fib_mpsc_insert(queue, 50, NULL, NULL);
+    fib_mpsc_decrease_key(queue, handle, 10);
+    fib_node_t* node = fib_mpsc_extract_min(queue);
+    TEST_ASSERT(node && node->key == 10 && fib_mpsc_get_stats(queue).decreases == 1,
+                "Decrease key goes through the ring");
+    free(node);
+
+    // A handle outlives its node: the consumer drops the message, even when
+    // a new ticketed node reuses the address
+    fib_mpsc_decrease_key(queue, handle, 1);
+    fib_mpsc_ticket_t reuse;
+    fib_mpsc_insert(queue, 200, NULL, &reuse);
+    fib_mpsc_drain(queue);
+    fib_mpsc_handle_t fresh = fib_mpsc_ticket_wait(&reuse);
+    fib_mpsc_decrease_key(queue, handle, 1);
+    node = fib_mpsc_minimum(queue);
+    stats = fib_mpsc_get_stats(queue);
+    TEST_ASSERT(node && node->key == 50 && stats.stale == 2 && stats.decreases == 1 &&
+                fresh.generation != handle.generation, "Stale handle is rejected");
+    fib_mpsc_handle_t deleted = fib_mpsc_ticket_wait(&tickets[2]);
+    TEST_ASSERT(fib_mpsc_delete_node(queue, (fib_node_t*)deleted.node) == FIB_HEAP_SUCCESS &&
+                fib_mpsc_decrease_key(queue, deleted, 1) == FIB_HEAP_SUCCESS &&
+                fib_mpsc_drain(queue) == 1 && fib_mpsc_get_stats(queue).stale == 3 &&
+                fib_mpsc_minimum(queue)->key == 50, "Deleting a node retires its handle");
+    fib_mpsc_handle_t none = {NULL, 0};
+    TEST_ASSERT(fib_mpsc_decrease_key(queue, none, 1) == FIB_HEAP_ERROR_INVALID_HANDLE,
+                "Empty handle refused");
+    while ((node = fib_mpsc_extract_min(queue)) != NULL) {
+        free(node);
+    }
+    fib_mpsc_destroy(queue);
+
+    // Compaction through the front-end moves the handles with their nodes
+    queue = fib_mpsc_create(heap, 8);
+    fib_mpsc_ticket_t moved[3];
+    for (int i = 0; i < 3; i++) {
+        fib_mpsc_insert(queue, 100 + i, NULL, &moved[i]);
+    }
+    fib_mpsc_drain(queue);
+    fib_mpsc_handle_t before = fib_mpsc_ticket_wait(&moved[1]);
+    int relocated = 0;
+    bool done = false;
+    TEST_ASSERT(fib_mpsc_compact(queue, 0, test_count_relocate_cb, &relocated, &done) == FIB_HEAP_SUCCESS &&
+                done && relocated == 3, "MPSC compaction chains to the caller's callback");
+    fib_mpsc_decrease_key(queue, before, 5);
+    node = fib_mpsc_minimum(queue);
+    TEST_ASSERT(node && node->key == 5 && node != before.node && fib_mpsc_get_stats(queue).stale == 0,
+                "A handle survives its node being moved");
+    while ((node = fib_mpsc_extract_min(queue)) != NULL) {
+        fib_heap_free_node(heap, node);
+    }
+    fib_mpsc_destroy(queue);
+
+    // Concurrent producers against a draining consumer
+    queue = fib_mpsc_create(heap, 1024);
+    pthread_t threads[4];
+    test_mpsc_producer_t producers[4];
+    for (int p = 0; p < 4; p++) {
+        producers[p] = (test_mpsc_producer_t){queue, p, 20000};
+        pthread_create(&threads[p], NULL, test_mpsc_producer, &producers[p]);
+    }
+    int next[4] = {0, 0, 0, 0};
+    bool in_order = true;
+    int received = 0;
+    while (received < 80000) {
+        fib_mpsc_drain(queue);
+        while ((node = fib_heap_extract_min(heap)) != NULL) {
+            // A producer's keys grow with its sequence, so each arrives in order
+            int p = node->key % 8;
+            in_order = in_order && node->key / 8 == next[p];
+            next[p]++;
+            received++;
+            free(node);
+        }
+    }
+    for (int p = 0; p < 4; p++) {
+        pthread_join(threads[p], NULL);
+    }
+    TEST_ASSERT(in_order && fib_mpsc_drain(queue) == 0, "Every concurrent insert arrives once, in order");
+    TEST_ASSERT(fib_mpsc_get_stats(queue).inserts == 80000, "Insert counter matches");
+
+    fib_mpsc_destroy(queue);
+    fib_heap_destroy(heap);
+    printf("\n");
+}
+
+// Test the duplicate-key coalescing heap
+void test_bucket_heap() {
+    printf("=== Testing Coalescing Bucket Heap ===\n");
+
+    fib_bucket_heap_t* heap = fib_bucket_heap_create();
+    TEST_ASSERT(heap != NULL, "Bucket heap creation");
+    TEST_ASSERT(!fib_bucket_heap_extract_min(heap).valid, "Extract from empty bucket heap");
+
+    // 256 levels, enough items per level to span several chunks
+    static int ids[20000];
+    for (int i = 0; i < 20000; i++) {
+        ids[i] = i;
+        fib_bucket_heap_insert(heap, (i * 37) % 256 - 128, &ids[i]);
+    }
+    TEST_ASSERT(fib_bucket_heap_size(heap) == 20000 && fib_bucket_heap_distinct_keys(heap) == 256,
+                "One node per distinct key");
+
+    fib_bucket_item_t min = fib_bucket_heap_minimum(heap);
+    TEST_ASSERT(min.valid && min.key == -128 && *(int*)min.data == 0, "Minimum is the oldest smallest item");
+
+    // Drain half, inserting new and existing keys on the way
+    bool ordered = true;
+    int previous_key = INT_MIN;
+    int previous_id = -1;
+    for (int i = 0; i < 10000; i++) {
+        fib_bucket_item_t item = fib_bucket_heap_extract_min(heap);
+        int id = *(int*)item.data;
+        if (item.key == previous_key) {
+            ordered = ordered && id > previous_id;
+        } else {
+            ordered = ordered && item.key > previous_key;
+        }
+        previous_key = item.key;
+        previous_id = id;
+    }
+    TEST_ASSERT(ordered, "Keys ascend and equal keys come out in insertion order");
+
+    fib_bucket_heap_insert(heap, previous_key, &ids[19999]);
+    fib_bucket_heap_insert(heap, -1000, &ids[1]);
+    fib_bucket_item_t item = fib_bucket_heap_extract_min(heap);
+    TEST_ASSERT(item.key == -1000 && item.data == &ids[1] &&
+                fib_bucket_heap_distinct_keys(heap) == 256 - (size_t)(previous_key + 128),
+                "New smallest key is extracted and its node removed");
+    item = fib_bucket_heap_minimum(heap);
+    TEST_ASSERT(item.key == previous_key && *(int*)item.data != 19999,
+                "Appended item queues behind its key's older items");
+
+    size_t remaining = 0;
+    while (fib_bucket_heap_extract_min(heap).valid) {
+        remaining++;
+    }
+    TEST_ASSERT(remaining == 10001 && fib_bucket_heap_size(heap) == 0 &&
+                fib_bucket_heap_distinct_keys(heap) == 0, "Bucket heap drains completely");
+    TEST_ASSERT(fib_bucket_heap_insert(NULL, 1, NULL) == FIB_HEAP_ERROR_NULL_POINTER,
+                "Insert into NULL bucket heap");
+    fib_bucket_heap_destroy(heap);
+    printf("\n");
+}
+
+// Test the operation trace recorder
+void test_trace() {
+    printf("=== Testing Operation Trace ===\n");
+
+    // Ring-only recorder keeps the most recent records
+    fib_trace_t* ring = fib_trace_create(4, NULL);
+    fib_heap_t* heap = fib_heap_create();
+    TEST_ASSERT(fib_trace_attach(ring, heap) == FIB_HEAP_SUCCESS, "Attach recorder");
+
+    fib_node_t* a = fib_heap_insert(heap, 10, NULL);
+    fib_node_t* b = fib_heap_insert(heap, 20, NULL);
+    fib_heap_decrease_key(heap, b, 5);
+    fib_node_t* min = fib_heap_extract_min(heap);
+    fib_heap_delete_node(heap, a);
+
+    fib_trace_record_t records[8];
+    size_t n = fib_trace_snapshot(ring, records, 8);
+    TEST_ASSERT(fib_trace_total_records(ring) == 5 && n == 4, "Ring keeps the newest records");
+    TEST_ASSERT(records[0].op == FIB_HEAP_OP_INSERT && records[0].node == (uint64_t)(uintptr_t)b &&
+                records[0].key == 20, "Oldest kept record is the second insert");
+    TEST_ASSERT(records[1].op == FIB_HEAP_OP_DECREASE_KEY && records[1].key == 5, "Decrease-key recorded");
+    TEST_ASSERT(records[2].op == FIB_HEAP_OP_EXTRACT_MIN && records[2].node == (uint64_t)(uintptr_t)min,
+                "Extract-min recorded with its node");
+    TEST_ASSERT(records[3].op == FIB_HEAP_OP_DELETE && records[3].key == 10,
+                "Delete recorded once, without an inner extract-min");
+    fib_heap_free_node(heap, min);
+    fib_heap_destroy(heap);
+    fib_trace_destroy(ring);
+
+    // File recorder flushes every record, across ring wraparounds
+    char path[] = "/tmp/fibheap-trace-XXXXXX";
+    int fd = mkstemp(path);
+    close(fd);
+    fib_trace_t* file = fib_trace_create(3, path);
+    fib_heap_t* h1 = fib_heap_create();
+    fib_heap_t* h2 = fib_heap_create();
+    fib_trace_attach(file, h1);
+    fib_trace_attach(file, h2);
+    for (int i = 0; i < 5; i++) {
+        fib_heap_insert(i % 2 ? h1 : h2, i, NULL);
+    }
+    fib_heap_union(h1, h2);
+    fib_trace_destroy(file);
+
+    fib_trace_record_t* loaded = NULL;
+    size_t count = 0;
+    TEST_ASSERT(fib_trace_load(path, &loaded, &count) == FIB_HEAP_SUCCESS && count == 6,
+                "Trace file holds every record");
+    TEST_ASSERT(loaded && loaded[5].op == FIB_HEAP_OP_UNION && loaded[5].heap == (uint64_t)(uintptr_t)h1 &&
+                loaded[5].other == (uint64_t)(uintptr_t)h2, "Union recorded with both heaps");
+    free(loaded);
+    unlink(path);
+
+    fib_heap_set_trace(h1, NULL, NULL);
+    fib_heap_set_trace(h2, NULL, NULL);
+    fib_heap_destroy(h1);
+    fib_heap_destroy(h2);
+    printf("\n");
+}
+
+// Concurrent peek test reader: snapshots must always be internally consistent
+static int peek_stop = 0;
+static void* test_peek_reader(void* arg) {
+    fib_heap_t* heap = (fib_heap_t*)arg;
+    long bad = 0;
+    while (!__atomic_load_n(&peek_stop, __ATOMIC_ACQUIRE)) {
+        fib_heap_min_snapshot_t min = fib_heap_peek_min(heap);
+        size_t size = fib_heap_size(heap);
+        if ((min.valid && (min.key < 0 || min.key >= 1000)) || size > 1000) {
+            bad++;
+        }
+    }
+    return (void*)bad;
+}
+
+// Test concurrent mode (published minimum for lock-free readers)
+void test_concurrent_peek() {
+    printf("=== Testing Concurrent Peek ===\n");
+
+    fib_heap_t* heap = fib_heap_create();
+    fib_heap_insert(heap, 7, NULL);
+    TEST_ASSERT(fib_heap_set_concurrent(heap, true) == FIB_HEAP_SUCCESS, "Enable concurrent mode");
+
+    fib_heap_min_snapshot_t min = fib_heap_peek_min(heap);
+    TEST_ASSERT(min.valid && min.key == 7, "Snapshot published on enable");
+
+    fib_node_t* node = fib_heap_insert(heap, 9, NULL);
+    fib_heap_decrease_key(heap, node, 3);
+    min = fib_heap_peek_min(heap);
+    TEST_ASSERT(min.valid && min.key == 3 && min.node == node, "Snapshot follows decrease-key");
+    TEST_ASSERT(fib_heap_size(heap) == 2, "Published size");
+
+    fib_heap_free_node(heap, fib_heap_extract_min(heap));
+    fib_heap_free_node(heap, fib_heap_extract_min(heap));
+    TEST_ASSERT(!fib_heap_peek_min(heap).valid && fib_heap_empty(heap), "Empty heap publishes no minimum");
+
+    // A cancelled minimum is released before a snapshot could show it
+    fib_node_t* cancelled = fib_heap_insert(heap, 1, NULL);
+    fib_heap_insert(heap, 5, NULL);
+    fib_heap_cancel(heap, cancelled);
+    min = fib_heap_peek_min(heap);
+    TEST_ASSERT(min.valid && min.key == 5 && fib_heap_size(heap) == 1, "Cancelled minimum is never published");
+    fib_heap_set_concurrent(heap, false);
+    fib_heap_cancel(heap, fib_heap_insert(heap, 2, NULL));
+    fib_heap_set_concurrent(heap, true);
+    min = fib_heap_peek_min(heap);
+    TEST_ASSERT(min.valid && min.key == 5 && fib_heap_size(heap) == 1 &&
+                fib_heap_get_statistics(heap).dead_nodes == 0, "Enabling releases a cancelled minimum first");
+    fib_heap_free_node(heap, fib_heap_extract_min(heap));
+
+    // One writer mutating while another thread peeks
+    pthread_t reader;
+    peek_stop = 0;
+    pthread_create(&reader, NULL, test_peek_reader, heap);
+    for (int round = 0; round < 50; round++) {
+        for (int i = 999; i >= 0; i--) {
+            fib_heap_insert(heap, i, NULL);
+        }
+        while (!fib_heap_empty(heap)) {
+            fib_heap_free_node(heap, fib_heap_extract_min(heap));
+        }
+    }
+    __atomic_store_n(&peek_stop, 1, __ATOMIC_RELEASE);
+    void* bad = NULL;
+    pthread_join(reader, &bad);
+    TEST_ASSERT(bad == NULL, "Readers never observe a torn snapshot");
+    fib_heap_destroy(heap);
+
+    // Monotone mode: publishing does not locate the minimum after an extraction
+    heap = fib_heap_create();
+    fib_heap_set_monotone(heap, true);
+    fib_heap_set_concurrent(heap, true);
+    fib_heap_insert(heap, 10, NULL);
+    fib_heap_insert(heap, 30, NULL);
+    node = fib_heap_insert(heap, 20, NULL);
+    fib_heap_free_node(heap, fib_heap_extract_min(heap));
+    min = fib_heap_peek_min(heap);
+    TEST_ASSERT(!min.valid && min.key <= 20 && min.key > 10 && fib_heap_size(heap) == 2,
+                "Unlocated monotone minimum publishes a lower bound");
+    TEST_ASSERT(fib_heap_minimum(heap) == node, "Monotone minimum located on demand");
+    min = fib_heap_peek_min(heap);
+    TEST_ASSERT(min.valid && min.key == 20 && min.node == node, "Located monotone minimum is published");
+
+    fib_heap_insert(heap, 20, NULL);
+    fib_heap_free_node(heap, fib_heap_extract_min(heap));
+    min = fib_heap_peek_min(heap);
+    TEST_ASSERT(min.valid && min.key == 20, "Floor-bucket minimum is published directly");
+
+    fib_heap_destroy(heap);
+    printf("\n");
+}
+
+// Scheduler test task: count runs and fan out while depth remains
+static int sched_runs = 0;
+static void test_sched_task(fib_sched_t* sched, size_t worker, void* user_ctx) {
+    uintptr_t depth = (uintptr_t)user_ctx;
+    __atomic_fetch_add(&sched_runs, 1, __ATOMIC_RELAXED);
+    if (depth > 0) {
+        fib_sched_submit(sched, worker, (int)depth, test_sched_task, (void*)(depth - 1));
+        fib_sched_submit(sched, worker, (int)depth, test_sched_task, (void*)(depth - 1));
+    }
+}
+
+// Test the work-stealing scheduler
+void test_scheduler() {
+    printf("=== Testing Work-Stealing Scheduler ===\n");
+
+    fib_sched_t* sched = fib_sched_create(4, 0);
+    TEST_ASSERT(sched != NULL && fib_sched_workers(sched) == 4, "Scheduler creation");
+
+    // 16 task trees of depth 6: 16 * 127 tasks in total
+    sched_runs = 0;
+    for (int i = 0; i < 16; i++) {
+        fib_sched_submit(sched, FIB_SCHED_ANY_WORKER, i, test_sched_task, (void*)6);
+    }
+    fib_sched_wait_idle(sched);
+    TEST_ASSERT(__atomic_load_n(&sched_runs, __ATOMIC_RELAXED) == 16 * 127, "All spawned tasks run");
+    TEST_ASSERT(fib_sched_get_stats(sched).tasks_run == 16 * 127, "Task counter matches");
+    TEST_ASSERT(fib_sched_submit(sched, 4, 0, test_sched_task, NULL) == FIB_HEAP_ERROR_INVALID_HANDLE,
+                "Submit to a nonexistent worker is rejected");
+
+    fib_sched_destroy(sched);
+    printf("\n");
+}
+
+// Relocation callback for the compaction test: data holds the handle index
+static int relocations_seen = 0;
+static void test_relocate_cb(fib_node_t* old_node, fib_node_t* new_node, void* user_ctx) {
+    fib_node_t** handles = (fib_node_t**)user_ctx;
+    int index = *(int*)new_node->data;
+    if (handles[index] == old_node) {
+        handles[index] = new_node;
+        relocations_seen++;
+    }
+}
+
+// Test online heap compaction
+void test_compaction() {
+    printf("=== Testing Compaction ===\n");
+
+    const int n = 500;
+    fib_heap_t* heap = fib_heap_create();
+    fib_node_t* handles[500];
+    int ids[500];
+
+    srand(3);
+    for (int i = 0; i < n; i++) {
+        ids[i] = i;
+        handles[i] = fib_heap_insert(heap, 1000 + rand() % 10000, &ids[i]);
+    }
+
+    // Build multi-level trees with some marked nodes
+    fib_node_t* first = fib_heap_extract_min(heap);
+    handles[*(int*)first->data] = NULL;
+    free(first);
+    for (int i = 0; i < n; i += 7) {
+        if (handles[i]) {
+            fib_heap_decrease_key(heap, handles[i], fib_node_get_key(handles[i]) - 500);
+        }
+    }
+
+    size_t size_before = fib_heap_size(heap);
+    relocations_seen = 0;
+    bool done = false;
+    int calls = 0;
+    while (!done && calls < 1000) {
+        fib_heap_error_t result = fib_heap_compact(heap, 16, test_relocate_cb, handles, &done);
+        if (result != FIB_HEAP_SUCCESS) {
+            break;
+        }
+        calls++;
+    }
+    TEST_ASSERT(done && calls > 1, "Budgeted compaction completes over several calls");
+    TEST_ASSERT((size_t)relocations_seen == size_before, "Every live node is relocated once per pass");
+    TEST_ASSERT(fib_heap_size(heap) == size_before, "Compaction preserves size");
+
+    // Relocated handles must remain usable
+    fib_heap_error_t result = FIB_HEAP_SUCCESS;
+    for (int i = 1; i < n && result == FIB_HEAP_SUCCESS; i += 3) {
+        if (handles[i]) {
+            result = fib_heap_decrease_key(heap, handles[i], fib_node_get_key(handles[i]) - 100);
+        }
+    }
+    TEST_ASSERT(result == FIB_HEAP_SUCCESS, "Decrease key through relocated handles");
+    TEST_ASSERT(fib_heap_delete_node(heap, handles[2]) == FIB_HEAP_SUCCESS,
+                "Delete a relocated node");
+    size_before--;
+
+    bool sorted = true;
+    int last = -1000000;
+    size_t count = 0;
+    while (!fib_heap_empty(heap)) {
+        fib_node_t* node = fib_heap_extract_min(heap);
+        if (node->key < last) {
+            sorted = false;
+        }
+        last = node->key;
+        count++;
+        fib_heap_free_node(heap, node);
+    }
+    TEST_ASSERT(sorted && count == size_before, "Heap order intact after compaction");
+
+    fib_heap_destroy(heap);
+    printf("\n");
+}
+
+// Test shared-memory heap across processes
+void test_shm_heap() {
+    printf("=== Testing Shared-Memory Heap ===\n");
+
+    const int num_workers = 4;
+    const int per_worker = 2000;
+    size_t region_size = fib_shm_heap_region_size(num_workers * per_worker);
+    void* region = mmap(NULL, region_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    TEST_ASSERT(region != MAP_FAILED, "Map shared region");
+
+    fib_shm_heap_t* heap = fib_shm_heap_init(region, region_size);
+    TEST_ASSERT(heap != NULL, "Shared heap initialization");
+    TEST_ASSERT(fib_shm_heap_attach(region) == heap, "Attach to initialized region");
+    TEST_ASSERT(fib_shm_heap_capacity(heap) >= (size_t)(num_workers * per_worker),
+                "Region holds requested node count");
+
+    // Single-process decrease key and delete
+    fib_shm_off_t h1, h2, h3;
+    fib_shm_heap_insert(heap, 30, 1, &h1);
+    fib_shm_heap_insert(heap, 20, 2, &h2);
+    fib_shm_heap_insert(heap, 40, 3, &h3);
+    TEST_ASSERT(fib_shm_heap_decrease_key(heap, h3, 10) == FIB_HEAP_SUCCESS,
+                "Shared decrease key succeeds");
+    TEST_ASSERT(fib_shm_heap_decrease_key(heap, h3, 50) == FIB_HEAP_ERROR_INVALID_KEY,
+                "Shared decrease key with larger value fails");
+    TEST_ASSERT(fib_shm_heap_delete_node(heap, h2) == FIB_HEAP_SUCCESS,
+                "Shared delete succeeds");
+    TEST_ASSERT(fib_shm_heap_delete_node(heap, h2) == FIB_HEAP_ERROR_INVALID_HANDLE,
+                "Deleting a freed slot is rejected");
+
+    // The freed slot is reused; the old handle must not reach the new node
+    fib_shm_off_t h4;
+    fib_shm_heap_insert(heap, 25, 4, &h4);
+    TEST_ASSERT(h4 != h2 && fib_shm_heap_decrease_key(heap, h2, 5) == FIB_HEAP_ERROR_INVALID_HANDLE,
+                "Stale handle to a reused slot is rejected");
+    fib_shm_heap_delete_node(heap, h4);
+
+    int key;
+    uint64_t value;
+    fib_shm_heap_extract_min(heap, &key, &value);
+    TEST_ASSERT(key == 10 && value == 3, "Shared extract returns decreased node");
+    fib_shm_heap_extract_min(heap, &key, &value);
+    TEST_ASSERT(key == 30 && value == 1, "Shared extract skips deleted node");
+    TEST_ASSERT(fib_shm_heap_extract_min(heap, &key, &value) == FIB_HEAP_ERROR_EMPTY_HEAP,
+                "Shared extract from empty heap fails");
+
+    // Concurrent writers in separate processes, each also extracting
+    for (int w = 0; w < num_workers; w++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            fib_shm_heap_t* child_heap = fib_shm_heap_attach(region);
+            srand(w + 1);
+            for (int i = 0; i < per_worker; i++) {
+                fib_shm_heap_insert(child_heap, rand() % 100000, (uint64_t)w, NULL);
+                if (i % 4 == 3) {
+                    fib_shm_heap_extract_min(child_heap, NULL, NULL);
+                }
+            }
+            _exit(0);
+        }
+    }
+
+    bool children_ok = true;
+    for (int w = 0; w < num_workers; w++) {
+        int status;
+        if (wait(&status) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            children_ok = false;
+        }
+    }
+    TEST_ASSERT(children_ok, "All worker processes completed");
+
+    size_t expected = (size_t)num_workers * (per_worker - per_worker / 4);
+    TEST_ASSERT(fib_shm_heap_size(heap) == expected, "Shared heap size matches operations");
+
+    bool sorted = true;
+    int last = -1;
+    size_t drained = 0;
+    while (fib_shm_heap_extract_min(heap, &key, NULL) == FIB_HEAP_SUCCESS) {
+        if (key < last) {
+            sorted = false;
+        }
+        last = key;
+        drained++;
+    }
+    TEST_ASSERT(sorted && drained == expected, "Shared heap drains in sorted order");
+
+    // A process killed while holding the lock: it keeps extracting and
+    // reinserting keys 0..n-1, so it dies mid-operation with high probability
+    const int churn_keys = 512;
+    for (int i = 0; i < churn_keys; i++) {
+        fib_shm_heap_insert(heap, i, (uint64_t)i, NULL);
+    }
+
+    int attempts = 0;
+    while (fib_shm_heap_owner_deaths(heap) == 0 && attempts++ < 200) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            fib_shm_heap_t* child_heap = fib_shm_heap_attach(region);
+            for (;;) {
+                if (fib_shm_heap_extract_min(child_heap, &key, &value) == FIB_HEAP_SUCCESS) {
+                    fib_shm_heap_insert(child_heap, key, value, NULL);
+                }
+            }
+        }
+        usleep(2000);
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+
+        // Take the lock so that a death is noticed and repaired
+        fib_shm_heap_minimum(heap, NULL, NULL);
+    }
+    TEST_ASSERT(fib_shm_heap_owner_deaths(heap) > 0, "Lock owner killed inside a critical section");
+
+    // Drain and check the forest; at most the key in flight may be lost
+    bool seen[512] = {false};
+    bool intact = true;
+    size_t size_before = fib_shm_heap_size(heap);
+    last = -1;
+    drained = 0;
+    while (fib_shm_heap_extract_min(heap, &key, &value) == FIB_HEAP_SUCCESS) {
+        if (key < last || key < 0 || key >= churn_keys || seen[key] || value != (uint64_t)key) {
+            intact = false;
+            break;
+        }
+        seen[key] = true;
+        last = key;
+        drained++;
+    }
+    TEST_ASSERT(intact && drained == size_before && drained >= (size_t)churn_keys - 1,
+                "Heap rebuilt after owner death drains intact");
+
+    munmap(region, region_size);
+    printf("\n");
+}
+
 // Run all tests
 int main() {
     printf("Starting Fibonacci Heap Tests...\n\n");
@@ -288,8 +1872,26 @@ int main() {
     test_decrease_key();
     test_delete();
     test_union();
+    test_steal();
     test_user_data();
     test_statistics();
+    test_shm_heap();
+    test_stable_mode();
+    test_bounded_heap();
+    test_compaction();
+    test_decrease_key_batch();
+    test_insert_batch();
+    test_event_loop();
+    test_scheduler();
+    test_concurrent_peek();
+    test_trace();
+    test_monotone_mode();
+    test_allocator();
+    test_drain_sorted();
+    test_cancel();
+    test_extmem();
+    test_bucket_heap();
+    test_mpsc();
     test_performance();
 
     printf("=== Test Summary ===\n");
@@ -0,0 +1,238 @@
+#include "fibonacci_heap.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Test result tracking
+static int tests_run = 0;
+static int tests_passed = 0;
+
+#define TEST_ASSERT(condition, message) \
+    do { \
+        tests_run++; \
+        if (condition) { \
+            tests_passed++; \
+            printf("PASS: %s\n", message); \
+        } else { \
+            printf("FAIL: %s\n", message); \
+        } \
+    } while(0)
+
+// Counts live instances to check that nodes destroy their values
+struct Tracked {
+    static int live;
+    int key;
+    explicit Tracked(int k) : key(k) { live++; }
+    Tracked(const Tracked& other) : key(other.key) { live++; }
+    ~Tracked() { live--; }
+    bool operator<(const Tracked& other) const { return key < other.key; }
+};
+int Tracked::live = 0;
+
+// Allocator that counts allocations to check allocator awareness
+static int counting_allocations = 0;
+template <class T>
+struct CountingAllocator {
+    using value_type = T;
+    CountingAllocator() = default;
+    template <class U>
+    CountingAllocator(const CountingAllocator<U>&) {}
+    T* allocate(std::size_t n) {
+        counting_allocations++;
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T* p, std::size_t n) {
+        counting_allocations--;
+        std::allocator<T>().deallocate(p, n);
+    }
+    template <class U>
+    bool operator==(const CountingAllocator<U>&) const { return true; }
+    template <class U>
+    bool operator!=(const CountingAllocator<U>&) const { return false; }
+};
+
+// Stateful allocator: instances of different arenas compare unequal and do
+// not propagate on move assignment, and each arena counts its live blocks
+static int arena_blocks[3] = {0, 0, 0};
+template <class T>
+struct ArenaAllocator {
+    using value_type = T;
+    int arena;
+    explicit ArenaAllocator(int a) : arena(a) {}
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+    T* allocate(std::size_t n) {
+        arena_blocks[arena]++;
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T* p, std::size_t n) {
+        arena_blocks[arena]--;
+        std::allocator<T>().deallocate(p, n);
+    }
+    template <class U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <class U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+// Test basic ordering
+void test_basic_operations() {
+    printf("=== Testing Basic Operations ===\n");
+
+    fib::FibonacciHeap<int> heap;
+    TEST_ASSERT(heap.empty() && heap.size() == 0, "New heap is empty");
+
+    int keys[] = {10, 5, 15, 3, 8, 12};
+    for (int key : keys) {
+        heap.push(key);
+    }
+    TEST_ASSERT(heap.size() == 6, "Heap size after pushes");
+    TEST_ASSERT(heap.top() == 3, "Top is smallest element");
+
+    bool sorted = true;
+    int last = -1;
+    while (!heap.empty()) {
+        int value = heap.extract_min();
+        if (value < last) {
+            sorted = false;
+        }
+        last = value;
+    }
+    TEST_ASSERT(sorted, "Elements are extracted in sorted order");
+
+    bool threw = false;
+    try {
+        heap.pop();
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    TEST_ASSERT(threw, "Pop on empty heap throws");
+    printf("\n");
+}
+
+// Test move-only payloads and emplace
+void test_move_only() {
+    printf("=== Testing Move-Only Payloads ===\n");
+
+    struct ByKey {
+        bool operator()(const std::unique_ptr<int>& a, const std::unique_ptr<int>& b) const {
+            return *a < *b;
+        }
+    };
+
+    fib::FibonacciHeap<std::unique_ptr<int>, ByKey> heap;
+    heap.emplace(new int(7));
+    heap.push(std::make_unique<int>(2));
+    auto h = heap.emplace(new int(9));
+    heap.decrease_key(h, std::make_unique<int>(1));
+
+    std::unique_ptr<int> first = heap.extract_min();
+    TEST_ASSERT(first && *first == 1, "Move-only value moved out after decrease key");
+    TEST_ASSERT(*heap.extract_min() == 2, "Second move-only value");
+    TEST_ASSERT(heap.size() == 1, "One move-only value left");
+    printf("\n");
+}
+
+// Test handles with decrease key and erase
+void test_handles() {
+    printf("=== Testing Handles ===\n");
+
+    fib::FibonacciHeap<std::pair<int, std::string>> heap;
+    std::vector<fib::FibonacciHeap<std::pair<int, std::string>>::handle> handles;
+    for (int i = 0; i < 100; i++) {
+        handles.push_back(heap.emplace(100 + i, "item" + std::to_string(i)));
+    }
+    heap.pop();
+
+    heap.decrease_key(handles[50], {1, "item50"});
+    TEST_ASSERT(heap.top().second == "item50", "Decrease key through handle");
+    TEST_ASSERT(handles[50]->first == 1, "Handle observes updated value");
+
+    bool threw = false;
+    try {
+        heap.decrease_key(handles[60], {500, "item60"});
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    TEST_ASSERT(threw, "Decrease key with greater value throws");
+
+    heap.erase(handles[50]);
+    heap.erase(handles[99]);
+    TEST_ASSERT(heap.size() == 97, "Erase removes elements");
+    TEST_ASSERT(heap.top().first == 101, "Top after erasing minimum");
+
+    fib::FibonacciHeap<std::pair<int, std::string>> other;
+    auto other_handle = other.emplace(0, "other");
+    heap.merge(other);
+    TEST_ASSERT(other.empty() && heap.size() == 98, "Merge moves all elements");
+    TEST_ASSERT(heap.top_handle() == other_handle, "Handles stay valid across merge");
+    printf("\n");
+}
+
+// Test value lifetime and allocator use
+void test_lifetime_and_allocator() {
+    printf("=== Testing Lifetime and Allocator ===\n");
+
+    {
+        fib::FibonacciHeap<Tracked, std::less<Tracked>, CountingAllocator<Tracked>> heap;
+        for (int i = 0; i < 50; i++) {
+            heap.emplace(rand() % 1000);
+        }
+        TEST_ASSERT(counting_allocations == 50, "Nodes come from the supplied allocator");
+        heap.pop();
+        Tracked moved = heap.extract_min();
+        TEST_ASSERT(Tracked::live == 49, "Popped values are destroyed");
+    }
+    TEST_ASSERT(Tracked::live == 0, "Destructor destroys remaining values");
+    TEST_ASSERT(counting_allocations == 0, "Destructor returns all nodes");
+
+    // Move assignment between heaps whose allocators differ and do not propagate
+    using ArenaHeap = fib::FibonacciHeap<int, std::less<int>, ArenaAllocator<int>>;
+    static_assert(!std::is_nothrow_move_assignable_v<ArenaHeap>,
+                  "Element-wise move assignment may throw");
+    static_assert(std::is_nothrow_move_assignable_v<fib::FibonacciHeap<int>>,
+                  "Move assignment with std::allocator does not throw");
+    {
+        ArenaHeap source{ArenaAllocator<int>(1)};
+        ArenaHeap target{ArenaAllocator<int>(2)};
+        for (int i = 0; i < 40; i++) {
+            source.push((i * 17) % 40);
+            target.push(i);
+        }
+        source.pop();       // Consolidate so the source has child lists
+        target = std::move(source);
+        TEST_ASSERT(source.empty() && arena_blocks[1] == 0,
+                    "Source nodes are returned to the source allocator");
+        TEST_ASSERT(target.size() == 39 && arena_blocks[2] == 39,
+                    "Moved elements live in the target allocator");
+
+        bool ordered = true;
+        for (int expected = 1; !target.empty(); expected++) {
+            ordered = ordered && target.extract_min() == expected;
+        }
+        TEST_ASSERT(ordered, "Element-wise move keeps every element");
+    }
+    TEST_ASSERT(arena_blocks[1] == 0 && arena_blocks[2] == 0, "Arena allocators balance");
+    printf("\n");
+}
+
+// Run all tests
+int main() {
+    printf("Starting C++ Fibonacci Heap Tests...\n\n");
+
+    test_basic_operations();
+    test_move_only();
+    test_handles();
+    test_lifetime_and_allocator();
+
+    printf("=== Test Summary ===\n");
+    printf("Tests run: %d\n", tests_run);
+    printf("Tests passed: %d\n", tests_passed);
+    printf("Tests failed: %d\n", tests_run - tests_passed);
+    printf("Success rate: %.1f%%\n", (double)tests_passed / tests_run * 100.0);
+
+    return (tests_passed == tests_run) ? 0 : 1;
+}